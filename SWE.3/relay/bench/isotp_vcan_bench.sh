@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# @file isotp_vcan_bench.sh
+# @brief ISO-TP blob throughput through the relay on vcan0.
+#
+# Sets up vcan0 and the can-isotp module, runs isotprecv as the peer,
+# starts the relay with its ISO-TP channel on vcan0, pushes N binary
+# BLOB messages of 4 KiB over TCP and reports KiB/s. Each connection is
+# closed by the relay only after send_blob() returns, and the socket
+# waits for TX done, so the client-side rate covers the whole bus transfer.
+#
+# Needs root, can-utils (isotprecv), coreutils (stdbuf) and python3. Build the relay first:
+#   gcc -O2 -std=gnu11 -pthread *.c -o relay
+# Run from SWE.3/relay:
+#   sudo bench/isotp_vcan_bench.sh [blobs] [relay binary]
+#
+# Exits non-zero if the peer did not receive every blob.
+
+set -eu
+
+BLOBS=${1:-100}
+RELAY=${2:-./relay}
+IFACE=vcan0
+PORT=5099
+SIZE=4096
+TX_ID=6F0   # relay -> peer
+RX_ID=6F8   # peer -> relay (flow control)
+
+WORK=$(mktemp -d)
+PEER_PID=
+RELAY_PID=
+
+cleanup() {
+    [ -n "$RELAY_PID" ] && kill -INT "$RELAY_PID" 2>/dev/null && wait "$RELAY_PID" 2>/dev/null
+    [ -n "$PEER_PID" ] && kill "$PEER_PID" 2>/dev/null
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+for tool in modprobe ip isotprecv stdbuf python3; do
+    command -v "$tool" >/dev/null 2>&1 || { echo "missing $tool" >&2; exit 2; }
+done
+[ -x "$RELAY" ] || { echo "relay binary $RELAY not found" >&2; exit 2; }
+
+modprobe vcan
+modprobe can-isotp
+ip link show "$IFACE" >/dev/null 2>&1 || ip link add dev "$IFACE" type vcan
+ip link set up "$IFACE"
+
+# Peer: receive on the relay's TX ID, send flow control on its RX ID, one line per PDU
+stdbuf -oL isotprecv -s "$RX_ID" -d "$TX_ID" -l "$IFACE" >"$WORK/peer.log" &
+PEER_PID=$!
+
+cat >"$WORK/relay.conf" <<EOF
+port = $PORT
+backend = vcan
+can = $IFACE
+isotp_tx_id = 0x$TX_ID
+isotp_rx_id = 0x$RX_ID
+metrics_interval = 1
+EOF
+"$RELAY" -c "$WORK/relay.conf" >"$WORK/relay.log" 2>&1 &
+RELAY_PID=$!
+sleep 1
+
+python3 - "$PORT" "$BLOBS" "$SIZE" <<'EOF'
+import os, socket, struct, sys, time
+
+port, count, size = (int(a) for a in sys.argv[1:4])
+msg = b"BLOB" + struct.pack(">H", size) + os.urandom(size)
+
+start = time.monotonic()
+for _ in range(count):
+    with socket.create_connection(("127.0.0.1", port)) as s:
+        s.sendall(msg)
+        s.shutdown(socket.SHUT_WR)
+        s.recv(1)  # EOF once the relay has sent the PDU
+elapsed = time.monotonic() - start
+print(f"{count} x {size} B blobs in {elapsed:.3f} s: {count * size / 1024 / elapsed:.1f} KiB/s")
+EOF
+
+# Stop the relay so its metrics output is flushed
+sleep 1
+kill -INT "$RELAY_PID"
+wait "$RELAY_PID" || true
+RELAY_PID=
+
+RECEIVED=$(wc -l <"$WORK/peer.log")
+echo "peer received $RECEIVED/$BLOBS blobs"
+# Relay-side view: time in ISO-TP writes, and bus load including the ISO-TP loopback frames
+grep '^isotp' "$WORK/relay.log" | tail -n 1 || true
+grep '^bus_load' "$WORK/relay.log" | sort -t= -k2 -n | tail -n 1 | sed 's/^/peak /' || true
+
+[ "$RECEIVED" -eq "$BLOBS" ]
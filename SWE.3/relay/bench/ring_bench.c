@@ -0,0 +1,350 @@
+/*
+ * @file ring_bench.c
+ * @brief Kernel-free check and benchmark of the JSON -> dispatch -> encode path.
+ *
+ * Runs the relay on the in-memory ring backend: JSON messages go through
+ * ethernet_process_message() and the resulting frames are taken back
+ * with can_backend_ring_drain(); relay commands are fed in with
+ * can_backend_ring_inject(). No root, vcan or syscalls on the CAN path.
+ *
+ * Build and run from SWE.3/relay:
+ *   gcc -O2 -std=gnu11 -pthread -DCAN_RELAY_LOG_LEVEL=LOG_INFO -I. \
+ *       $(ls *.c | grep -v '^main.c$') bench/ring_bench.c -o ring_bench
+ *   ./ring_bench [messages]
+ *
+ * Exits non-zero if any functional check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "can_relay.h"
+#include "can_backend.h"
+#include "ethernet_communication_handler.h"
+
+/** @brief Frames drained per call */
+#define DRAIN_BATCH 256u
+/** @brief Ring backend TX capacity (RING_CAPACITY in can_backend_ring.c) */
+#define RING_FRAMES 4096u
+/** @brief Frames a safety-class ID can hold while the controller is busy (TXQ_FIFO_DEPTH) */
+#define SAFETY_FIFO_FRAMES 8u
+/** @brief Velocity updates pushed by the throttle check */
+#define THROTTLE_PUSHES 5000u
+/** @brief Velocity updates between relay commands in the throttle check */
+#define THROTTLE_CMD_EVERY 50u
+
+static int failures = 0;
+
+/**
+ * @brief Record a failed check.
+ */
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * @brief Send one JSON message and expect exactly one frame back.
+ */
+static void check_json(const char *json, uint32_t id, const uint8_t *data, uint8_t len)
+{
+    struct can_frame f[DRAIN_BATCH];
+
+    check(ethernet_process_message(json) == 0, json);
+    size_t n = can_backend_ring_drain(f, DRAIN_BATCH);
+    check(n == 1u && f[0].can_id == id && f[0].can_dlc == len &&
+          memcmp(f[0].data, data, len) == 0, json);
+}
+
+/**
+ * @brief Functional checks of every signal and a relay command round trip.
+ */
+static void run_checks(void)
+{
+    struct can_frame f[DRAIN_BATCH];
+    float v = 12.5f;
+    uint8_t vel[4];
+    memcpy(vel, &v, sizeof(vel));
+
+    check_json("{\"signal\": \"battery_level\", \"value\": 87}", CAN_BATTERY_ID, (const uint8_t[]){87u}, 1u);
+    check_json("{\"signal\": \"velocity\", \"value\": 12.5}", CAN_VELOCITY_ID, vel, 4u);
+    check_json("{\"signal\": \"charging_active\", \"value\": true}", CAN_CHARGING_ACTIVE_ID, (const uint8_t[]){1u}, 1u);
+    check_json("{\"signal\": \"charge_request\", \"value\": false}", CAN_CHARGE_REQUEST_ID, (const uint8_t[]){0u}, 1u);
+    check(ethernet_process_message("{\"signal\": \"unknown\", \"value\": 1}") != 0, "unknown signal rejected");
+    check(can_backend_ring_drain(f, DRAIN_BATCH) == 0u, "unknown signal sends nothing");
+
+    /* SET relay 3 on: expect relay state and a STATUS_SINGLE reply */
+    struct can_frame cmd = { .can_id = 0x400u, .can_dlc = 3u, .data = {0x01u, 3u, 1u} };
+    check(can_backend_ring_inject(&cmd, 1u) == 1u, "inject relay command");
+    check(can_relay_poll() == 1, "poll reads relay command");
+    check(can_relay_get(3u), "relay 3 switched on");
+    size_t n = can_backend_ring_drain(f, DRAIN_BATCH);
+    check(n == 1u && f[0].can_id == 0x401u && f[0].data[0] == 0x11u &&
+          f[0].data[1] == 3u && f[0].data[2] == 1u, "status reply for relay 3");
+}
+
+/**
+ * @brief Status replies queued behind a full controller must all go out, in order.
+ */
+static void run_busy_checks(void)
+{
+    struct can_frame f[DRAIN_BATCH];
+    size_t n;
+
+    /* fill the TX ring, then one more frame stays queued */
+    for (uint32_t i = 0u; i <= RING_FRAMES; ++i) {
+        (void)ethernet_process_message("{\"signal\": \"battery_level\", \"value\": 50}");
+    }
+    for (uint8_t relay = 0u; relay < 3u; ++relay) {
+        struct can_frame cmd = { .can_id = 0x400u, .can_dlc = 3u, .data = {0x01u, relay, 1u} };
+        check(can_backend_ring_inject(&cmd, 1u) == 1u, "inject relay command while busy");
+    }
+    check(can_relay_poll() == 3, "poll reads relay commands while busy");
+
+    while (can_backend_ring_drain(f, DRAIN_BATCH) > 0u) {
+    }
+    (void)can_relay_poll();
+    n = can_backend_ring_drain(f, DRAIN_BATCH);
+    check(n == 4u, "busy: three status replies and one signal queued");
+    for (uint8_t relay = 0u; relay < 3u && relay < n; ++relay) {
+        check(f[relay].can_id == 0x401u && f[relay].data[0] == 0x11u &&
+              f[relay].data[1] == relay && f[relay].data[2] == 1u, "busy: status reply order");
+    }
+    check(n == 4u && f[3].can_id == CAN_BATTERY_ID, "busy: queued signal sent last");
+
+    /* a safety frame that does not fit its FIFO is refused and counted, not merged */
+    can_relay_metrics_t before, after;
+    can_relay_get_metrics(&before);
+    for (uint32_t i = 0u; i < RING_FRAMES; ++i) {
+        (void)ethernet_process_message("{\"signal\": \"battery_level\", \"value\": 50}");
+    }
+    for (uint32_t i = 0u; i < SAFETY_FIFO_FRAMES; ++i) {
+        check(send_charge_request((i & 1u) != 0u) == 0, "busy: charge request queued");
+    }
+    check(send_charge_request(true) != 0, "busy: charge request refused on full FIFO");
+    can_relay_get_metrics(&after);
+    check(after.safety_dropped == before.safety_dropped + 1u, "busy: safety drop counted");
+    check(after.coalesced == before.coalesced, "busy: safety frames not coalesced");
+
+    while (can_backend_ring_drain(f, DRAIN_BATCH) > 0u) {
+    }
+    (void)can_relay_poll();
+    n = can_backend_ring_drain(f, DRAIN_BATCH);
+    bool order = (n >= SAFETY_FIFO_FRAMES);
+    for (uint32_t i = 0u; i < SAFETY_FIFO_FRAMES && order; ++i) {
+        order = (f[i].can_id == CAN_CHARGE_REQUEST_ID) && (f[i].data[0] == (uint8_t)(i & 1u));
+    }
+    check(order, "busy: queued charge requests sent in order");
+    while (can_backend_ring_drain(f, DRAIN_BATCH) > 0u) {
+    }
+}
+
+/**
+ * @brief Above the load ceiling, velocity is throttled while status replies,
+ *        charging_active and charge_request all go out.
+ */
+static void run_throttle_checks(void)
+{
+    struct can_frame f[DRAIN_BATCH];
+    can_relay_metrics_t before, after;
+    uint32_t commands = 0u, controls = 0u;
+    uint32_t replies = 0u, velocity = 0u, active = 0u, request = 0u;
+
+    /* 125 kbit/s: about 80 velocity frames fill 60% of the 100 ms window */
+    can_relay_set_bus_limits(125000u, 60u, 0u);
+    can_relay_get_metrics(&before);
+
+    for (uint32_t i = 0u; i < THROTTLE_PUSHES; ++i) {
+        (void)ethernet_process_message("{\"signal\": \"velocity\", \"value\": 12.5}");
+        if ((i % THROTTLE_CMD_EVERY) == 0u) {
+            uint8_t relay = (uint8_t)((i / THROTTLE_CMD_EVERY) % 8u);
+            struct can_frame cmd = { .can_id = 0x400u, .can_dlc = 3u, .data = {0x01u, relay, 1u} };
+            commands += (uint32_t)can_backend_ring_inject(&cmd, 1u);
+            (void)can_relay_poll();
+            (void)ethernet_process_message("{\"signal\": \"charging_active\", \"value\": true}");
+            (void)ethernet_process_message("{\"signal\": \"charge_request\", \"value\": true}");
+            controls++;
+        }
+        size_t n = can_backend_ring_drain(f, DRAIN_BATCH);
+        for (size_t j = 0u; j < n; ++j) {
+            replies += (f[j].can_id == 0x401u) ? 1u : 0u;
+            velocity += (f[j].can_id == CAN_VELOCITY_ID) ? 1u : 0u;
+            active += (f[j].can_id == CAN_CHARGING_ACTIVE_ID) ? 1u : 0u;
+            request += (f[j].can_id == CAN_CHARGE_REQUEST_ID) ? 1u : 0u;
+        }
+    }
+    can_relay_get_metrics(&after);
+
+    printf("throttle: %u/%u velocity frames sent, %u/%u status replies\n",
+           velocity, THROTTLE_PUSHES, replies, commands);
+    check(replies == commands, "throttle: every status reply sent");
+    check(velocity > 0u && velocity < THROTTLE_PUSHES, "throttle: velocity cut back");
+    check(after.throttle_deferrals > before.throttle_deferrals, "throttle: deferrals counted");
+    check(after.coalesced > before.coalesced, "throttle: deferred velocity coalesced");
+    check(active == controls, "throttle: charging_active never deferred");
+    check(request == controls, "throttle: charge_request never deferred");
+
+    /* leave nothing queued for the following checks */
+    can_relay_set_bus_limits(0u, 0u, 0u);
+    (void)can_relay_poll();
+    while (can_backend_ring_drain(f, DRAIN_BATCH) > 0u) {
+    }
+}
+
+/**
+ * @brief Re-open the relay on the ring backend, as after a restart.
+ */
+static void restart_relay(void)
+{
+    can_relay_close();
+    check(can_relay_init_ex(NULL) == 0, "state: re-init");
+    can_relay_set_bus_limits(0u, 0u, 0u);
+}
+
+/**
+ * @brief Flip a byte in the newest record of a state file.
+ * @note Layout of state_file_t in relay_state_store.c: 8-byte header
+ *       (record_size at offset 6), then two records starting with a
+ *       64-bit generation; relay_mask follows the generation.
+ */
+static bool corrupt_newest_record(const char *path)
+{
+    FILE *fp = fopen(path, "r+b");
+    uint8_t hdr[8];
+    uint64_t gen[2] = {0u, 0u};
+    bool ok = (fp != NULL) && (fread(hdr, 1u, sizeof(hdr), fp) == sizeof(hdr));
+
+    if (ok) {
+        long rec_size = (long)(hdr[6] | (hdr[7] << 8));
+        for (long i = 0; i < 2 && ok; ++i) {
+            ok = (fseek(fp, 8L + (i * rec_size), SEEK_SET) == 0) &&
+                 (fread(&gen[i], sizeof(gen[i]), 1u, fp) == 1u);
+        }
+        long pos = 8L + ((gen[1] > gen[0]) ? rec_size : 0L) + (long)sizeof(uint64_t);
+        uint8_t b = 0u;
+        ok = ok && (fseek(fp, pos, SEEK_SET) == 0) && (fread(&b, 1u, 1u, fp) == 1u);
+        b ^= 0xFFu;
+        ok = ok && (fseek(fp, pos, SEEK_SET) == 0) && (fwrite(&b, 1u, 1u, fp) == 1u);
+    }
+    if (fp != NULL) {
+        ok = (fclose(fp) == 0) && ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Warm restart restores relays and re-emits signals; a corrupted
+ *        newest record falls back to the previous generation.
+ */
+static void run_state_checks(void)
+{
+    struct can_frame f[DRAIN_BATCH];
+    char path[] = "/tmp/ring_bench_stateXXXXXX";
+    int fd = mkstemp(path);
+    float v = 3.5f;
+    uint8_t vel[4];
+    memcpy(vel, &v, sizeof(vel));
+
+    check(fd >= 0, "state: temp file");
+    if (fd < 0) {
+        return;
+    }
+    (void)close(fd);
+
+    check(can_relay_restore_state(path, true) == 0, "state: open empty file");
+    /* earlier checks switched relays on */
+    (void)can_relay_set_mask(0u);
+    (void)can_relay_set(1u, true);
+    (void)can_relay_set(4u, true);
+    check(send_battery_level(77u) == 0, "state: send battery");
+    check(send_velocity(v) == 0, "state: send velocity");
+    check(send_charge_request(true) == 0, "state: send charge request");
+    /* newest generation differs from the previous one only in relay 6 */
+    (void)can_relay_set(6u, true);
+    while (can_backend_ring_drain(f, DRAIN_BATCH) > 0u) {
+    }
+
+    restart_relay();
+    check(!can_relay_get(1u), "state: relays cleared by init");
+    check(can_relay_restore_state(path, true) == 0, "state: restore");
+    check(can_relay_get(1u) && can_relay_get(4u) && can_relay_get(6u) && !can_relay_get(0u),
+          "state: relays restored");
+    size_t n = can_backend_ring_drain(f, DRAIN_BATCH);
+    bool battery = false, velocity = false, request = false;
+    for (size_t i = 0u; i < n; ++i) {
+        battery |= (f[i].can_id == CAN_BATTERY_ID && f[i].can_dlc == 1u && f[i].data[0] == 77u);
+        velocity |= (f[i].can_id == CAN_VELOCITY_ID && f[i].can_dlc == 4u && memcmp(f[i].data, vel, 4u) == 0);
+        request |= (f[i].can_id == CAN_CHARGE_REQUEST_ID && f[i].can_dlc == 1u && f[i].data[0] == 1u);
+    }
+    check(n == 3u && battery && velocity && request, "state: signals re-emitted");
+
+    restart_relay();
+    check(corrupt_newest_record(path), "state: corrupt newest record");
+    check(can_relay_restore_state(path, false) == 0, "state: restore after corruption");
+    check(can_relay_get(1u) && can_relay_get(4u) && !can_relay_get(6u),
+          "state: previous generation loaded");
+    check(can_backend_ring_drain(f, DRAIN_BATCH) == 0u, "state: no re-emit requested");
+
+    restart_relay();
+    (void)unlink(path);
+}
+
+/**
+ * @brief Throughput of JSON parse + dispatch + queue + encode.
+ */
+static void run_bench(long messages)
+{
+    static const char *const msgs[] = {
+        "{\"signal\": \"battery_level\", \"value\": 87}",
+        "{\"signal\": \"velocity\", \"value\": 12.5}",
+        "{\"signal\": \"charging_active\", \"value\": true}",
+        "{\"signal\": \"charge_request\", \"value\": false}",
+    };
+    struct can_frame f[DRAIN_BATCH];
+    struct timespec t0, t1;
+    long frames = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < messages; ++i) {
+        (void)ethernet_process_message(msgs[i & 3]);
+        if ((i & 63) == 63) {
+            frames += (long)can_backend_ring_drain(f, DRAIN_BATCH);
+        }
+    }
+    frames += (long)can_backend_ring_drain(f, DRAIN_BATCH);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double s = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%ld messages, %ld frames in %.3f s: %.2f M messages/s, %.0f ns/message\n",
+           messages, frames, s, (double)messages / s / 1e6, s * 1e9 / (double)messages);
+    check(frames == messages, "every message produced a frame");
+}
+
+int main(int argc, char *argv[])
+{
+    long messages = (argc > 1) ? atol(argv[1]) : 5000000L;
+
+    if (can_relay_set_backend(can_backend_ring()) != 0 || can_relay_init_ex(NULL) != 0) {
+        fprintf(stderr, "FAIL: ring backend init\n");
+        return 1;
+    }
+    /* benchmark measures software cost, not the throttle */
+    can_relay_set_bus_limits(0u, 0u, 0u);
+
+    run_checks();
+    run_busy_checks();
+    run_throttle_checks();
+    run_state_checks();
+    if (messages > 0) {
+        run_bench(messages);
+    }
+    can_relay_close();
+
+    printf("%s\n", (failures == 0) ? "OK" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
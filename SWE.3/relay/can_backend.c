@@ -0,0 +1,32 @@
+/*
+ * @file can_backend.c
+ * @brief CAN backend registry.
+ *
+ * Maps configuration names to the built-in backends:
+ * - "socketcan" / "can": SocketCAN on a physical controller (default can0)
+ * - "vcan": SocketCAN on a virtual interface (default vcan0)
+ * - "ring": in-process lock-free ring, no kernel involvement
+ */
+
+#include <string.h>
+#include "can_backend.h"
+
+/**
+ * @brief Find a backend by name.
+ * @param name Backend name. NULL or empty selects SocketCAN.
+ * @return Backend instance, or NULL if name is unknown.
+ */
+can_backend_t *can_backend_find(const char *name)
+{
+    if (name == NULL || name[0] == '\0' ||
+        strcmp(name, "socketcan") == 0 || strcmp(name, "can") == 0) {
+        return can_backend_socketcan();
+    }
+    if (strcmp(name, "vcan") == 0) {
+        return can_backend_vcan();
+    }
+    if (strcmp(name, "ring") == 0) {
+        return can_backend_ring();
+    }
+    return NULL;
+}
@@ -0,0 +1,33 @@
+#ifndef CAN_BACKEND_H
+#define CAN_BACKEND_H
+
+#include <stddef.h>
+#include <linux/can.h>
+
+// CAN backend: open/close return 0 on success, batch calls return frame count or negative error
+typedef struct can_backend can_backend_t;
+
+struct can_backend
+{
+    const char *name;
+    int (*open)(can_backend_t *self, const char *ifname);
+    int (*send_batch)(can_backend_t *self, const struct can_frame *frames, size_t count);
+    int (*recv_batch)(can_backend_t *self, struct can_frame *frames, size_t max); // non-blocking
+    void (*close)(can_backend_t *self);
+    void *ctx;
+};
+
+// Built-in backends
+can_backend_t *can_backend_socketcan(void);
+can_backend_t *can_backend_vcan(void);
+can_backend_t *can_backend_ring(void);
+
+// Lookup by name ("socketcan", "vcan", "ring"), NULL if unknown
+can_backend_t *can_backend_find(const char *name);
+
+// Ring backend access for benchmarks/tests: inject frames as if received from the bus,
+// drain frames the relay has sent
+size_t can_backend_ring_inject(const struct can_frame *frames, size_t count);
+size_t can_backend_ring_drain(struct can_frame *frames, size_t max);
+
+#endif // CAN_BACKEND_H
@@ -0,0 +1,191 @@
+/*
+ * @file can_backend_socketcan.c
+ * @brief SocketCAN backend (physical and virtual CAN interfaces).
+ *
+ * Batches are moved with sendmmsg()/recvmmsg() so one syscall carries
+ * up to SOCKETCAN_BATCH_MAX frames. Sends never block: a full controller
+ * queue returns a short count so the caller keeps the remaining frames
+ * in priority order. The vcan backend is the same implementation with
+ * its own socket and a vcan0 default.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "can_backend.h"
+
+/** @brief Frames per sendmmsg()/recvmmsg() call */
+#define SOCKETCAN_BATCH_MAX 64u
+
+/** @brief Per-instance SocketCAN state */
+typedef struct {
+    char ifname[IF_NAMESIZE]; /**< Bound interface name */
+    int sock;                 /**< Raw CAN socket, -1 when closed */
+} socketcan_ctx_t;
+
+/**
+ * @brief Open and bind a raw CAN socket.
+ * @param self Backend instance.
+ * @param ifname Interface name. If NULL or empty, keeps the instance default.
+ * @return 0 on success, -1 on failure.
+ */
+static int socketcan_open(can_backend_t *self, const char *ifname)
+{
+    socketcan_ctx_t *ctx = (socketcan_ctx_t *)self->ctx;
+
+    if (ifname != NULL && ifname[0] != '\0') {
+        strncpy(ctx->ifname, ifname, IF_NAMESIZE - 1u);
+        ctx->ifname[IF_NAMESIZE - 1u] = '\0';
+    }
+    if (ctx->sock >= 0) {
+        return 0;
+    }
+
+    struct ifreq ifr;
+    struct sockaddr_can addr;
+
+    int sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (sock < 0) {
+        return -1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ctx->ifname, IF_NAMESIZE - 1u);
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    ctx->sock = sock;
+    return 0;
+}
+
+/**
+ * @brief Write a batch of frames.
+ * @return Number of frames written, -1 if none could be written.
+ */
+static int socketcan_send_batch(can_backend_t *self, const struct can_frame *frames, size_t count)
+{
+    socketcan_ctx_t *ctx = (socketcan_ctx_t *)self->ctx;
+    struct mmsghdr msgs[SOCKETCAN_BATCH_MAX];
+    struct iovec iovs[SOCKETCAN_BATCH_MAX];
+    size_t sent = 0u;
+
+    if (ctx->sock < 0) {
+        return -1;
+    }
+    while (sent < count) {
+        size_t n = count - sent;
+        if (n > SOCKETCAN_BATCH_MAX) {
+            n = SOCKETCAN_BATCH_MAX;
+        }
+        memset(msgs, 0, n * sizeof(msgs[0]));
+        for (size_t i = 0u; i < n; ++i) {
+            iovs[i].iov_base = (void *)&frames[sent + i];
+            iovs[i].iov_len = sizeof(struct can_frame);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1u;
+        }
+        int r = sendmmsg(ctx->sock, msgs, (unsigned int)n, MSG_DONTWAIT);
+        if (r <= 0) {
+            break;
+        }
+        sent += (size_t)r;
+    }
+    return (sent > 0u || count == 0u) ? (int)sent : -1;
+}
+
+/**
+ * @brief Read pending frames without blocking.
+ * @return Number of frames read (0 if none pending), -1 on error.
+ */
+static int socketcan_recv_batch(can_backend_t *self, struct can_frame *frames, size_t max)
+{
+    socketcan_ctx_t *ctx = (socketcan_ctx_t *)self->ctx;
+    struct mmsghdr msgs[SOCKETCAN_BATCH_MAX];
+    struct iovec iovs[SOCKETCAN_BATCH_MAX];
+
+    if (ctx->sock < 0) {
+        return -1;
+    }
+    if (max > SOCKETCAN_BATCH_MAX) {
+        max = SOCKETCAN_BATCH_MAX;
+    }
+    memset(msgs, 0, max * sizeof(msgs[0]));
+    for (size_t i = 0u; i < max; ++i) {
+        iovs[i].iov_base = &frames[i];
+        iovs[i].iov_len = sizeof(struct can_frame);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1u;
+    }
+    int r = recvmmsg(ctx->sock, msgs, (unsigned int)max, MSG_DONTWAIT, NULL);
+    if (r < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    return r;
+}
+
+/**
+ * @brief Close the CAN socket.
+ */
+static void socketcan_close(can_backend_t *self)
+{
+    socketcan_ctx_t *ctx = (socketcan_ctx_t *)self->ctx;
+    if (ctx->sock >= 0) {
+        close(ctx->sock);
+        ctx->sock = -1;
+    }
+}
+
+static socketcan_ctx_t socketcan_ctx = { .ifname = "can0", .sock = -1 };
+static socketcan_ctx_t vcan_ctx = { .ifname = "vcan0", .sock = -1 };
+
+static can_backend_t socketcan_backend = {
+    .name = "socketcan",
+    .open = socketcan_open,
+    .send_batch = socketcan_send_batch,
+    .recv_batch = socketcan_recv_batch,
+    .close = socketcan_close,
+    .ctx = &socketcan_ctx,
+};
+
+static can_backend_t vcan_backend = {
+    .name = "vcan",
+    .open = socketcan_open,
+    .send_batch = socketcan_send_batch,
+    .recv_batch = socketcan_recv_batch,
+    .close = socketcan_close,
+    .ctx = &vcan_ctx,
+};
+
+/**
+ * @brief SocketCAN backend, default interface can0.
+ */
+can_backend_t *can_backend_socketcan(void)
+{
+    return &socketcan_backend;
+}
+
+/**
+ * @brief Virtual CAN backend, default interface vcan0.
+ */
+can_backend_t *can_backend_vcan(void)
+{
+    return &vcan_backend;
+}
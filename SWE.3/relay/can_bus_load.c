@@ -0,0 +1,88 @@
+/*
+ * @file can_bus_load.c
+ * @brief CAN bus load estimator.
+ *
+ * Frame length follows ISO 11898-1 for a classic 11-bit frame: 47 fixed
+ * bits (SOF, arbitration, control, CRC, ACK, EOF, intermission) plus
+ * 8 bits per data byte, plus the worst-case number of stuff bits over
+ * the stuffed region (SOF to CRC, 34 + 8*DLC bits). The estimate is
+ * therefore conservative. Bits are accumulated in LOAD_BUCKETS time
+ * buckets forming a sliding window of LOAD_BUCKETS * LOAD_BUCKET_NS.
+ */
+
+#include <string.h>
+#include "can_bus_load.h"
+
+/** @brief Number of buckets in the window */
+#define LOAD_BUCKETS    10u
+/** @brief Bucket width (10 ms, window 100 ms) */
+#define LOAD_BUCKET_NS  10000000ull
+
+/** @brief Estimator state */
+typedef struct {
+    uint32_t bitrate;               /**< Nominal bitrate in bit/s */
+    uint64_t tag[LOAD_BUCKETS];     /**< Absolute bucket number held in each slot */
+    uint32_t bits[LOAD_BUCKETS];    /**< Bits accounted per bucket */
+} bus_load_t;
+
+static bus_load_t bus_load = { .bitrate = 500000u };
+
+/**
+ * @brief Reset estimator.
+ * @param bitrate Nominal bitrate in bit/s (0 keeps 500 kbit/s).
+ */
+void can_bus_load_init(uint32_t bitrate)
+{
+    memset(&bus_load, 0, sizeof(bus_load));
+    bus_load.bitrate = (bitrate != 0u) ? bitrate : 500000u;
+    for (uint32_t i = 0u; i < LOAD_BUCKETS; ++i) {
+        bus_load.tag[i] = UINT64_MAX;
+    }
+}
+
+/**
+ * @brief Worst-case frame length in bits.
+ * @param dlc Data length (clamped to 8).
+ */
+uint32_t can_bus_load_frame_bits(uint8_t dlc)
+{
+    uint32_t n = (dlc > 8u) ? 8u : dlc;
+    uint32_t stuffed = 34u + (8u * n);
+    return 47u + (8u * n) + ((stuffed - 1u) / 4u);
+}
+
+/**
+ * @brief Account one frame.
+ * @param dlc Data length.
+ * @param now_ns Monotonic time in ns.
+ */
+void can_bus_load_add(uint8_t dlc, uint64_t now_ns)
+{
+    uint64_t slot = now_ns / LOAD_BUCKET_NS;
+    uint32_t i = (uint32_t)(slot % LOAD_BUCKETS);
+    if (bus_load.tag[i] != slot) {
+        bus_load.tag[i] = slot;
+        bus_load.bits[i] = 0u;
+    }
+    bus_load.bits[i] += can_bus_load_frame_bits(dlc);
+}
+
+/**
+ * @brief Current utilization.
+ * @param now_ns Monotonic time in ns.
+ * @return Bus load in permille (may exceed 1000 if frames are queued faster than the bus drains).
+ */
+uint32_t can_bus_load_permille(uint64_t now_ns)
+{
+    uint64_t slot = now_ns / LOAD_BUCKET_NS;
+    uint64_t bits = 0u;
+
+    for (uint32_t i = 0u; i < LOAD_BUCKETS; ++i) {
+        if (bus_load.tag[i] != UINT64_MAX && slot - bus_load.tag[i] < LOAD_BUCKETS) {
+            bits += bus_load.bits[i];
+        }
+    }
+    /* capacity of the window in bits = bitrate * LOAD_BUCKETS * LOAD_BUCKET_NS / 1e9 */
+    uint64_t capacity = ((uint64_t)bus_load.bitrate * LOAD_BUCKETS * LOAD_BUCKET_NS) / 1000000000ull;
+    return (uint32_t)((bits * 1000u) / capacity);
+}
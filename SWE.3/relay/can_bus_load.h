@@ -0,0 +1,18 @@
+#ifndef CAN_BUS_LOAD_H
+#define CAN_BUS_LOAD_H
+
+#include <stdint.h>
+
+// Sliding-window bus utilization estimator; not thread-safe, callers serialize
+void can_bus_load_init(uint32_t bitrate);
+
+// Bits on the wire for a classic standard-ID frame, worst-case stuffing
+uint32_t can_bus_load_frame_bits(uint8_t dlc);
+
+// Account one frame seen on the bus at now_ns (CLOCK_MONOTONIC)
+void can_bus_load_add(uint8_t dlc, uint64_t now_ns);
+
+// Utilization over the window ending at now_ns, in permille
+uint32_t can_bus_load_permille(uint64_t now_ns);
+
+#endif // CAN_BUS_LOAD_H
@@ -0,0 +1,29 @@
+#ifndef CAN_ISOTP_H
+#define CAN_ISOTP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Largest blob accepted (kernel uses the FF_DL escape above 4095 bytes)
+#define CAN_ISOTP_MAX_LEN 4096U
+
+// ISO-TP channel settings; block_size and stmin only go into FC frames we send while
+// receiving, blob sends are paced by the peer's FC (or tx_stmin_us)
+typedef struct
+{
+    uint32_t tx_id;         // CAN ID of frames we send
+    uint32_t rx_id;         // CAN ID of flow control frames from the peer
+    uint8_t block_size;     // BS we advertise in our FC frames, 0 = no limit
+    uint8_t stmin;          // STmin we advertise (0x00-0x7F ms, 0xF1-0xF9 100-900 us)
+    uint32_t tx_stmin_us;   // force our consecutive frame gap, 0 = honour peer FC
+} can_isotp_config_t;
+
+// Open kernel CAN_ISOTP socket on ifname, returns 0 on success
+int can_isotp_open(const char *ifname, const can_isotp_config_t *config);
+void can_isotp_close(void);
+
+// Send one blob; blocks until transmitted, returns 0 on success.
+// usec (may be NULL) receives the time on the bus, excluding the wait for other senders
+int can_isotp_send(const uint8_t *data, size_t len, uint64_t *usec);
+
+#endif // CAN_ISOTP_H
@@ -0,0 +1,77 @@
+/*
+ * @file can_rate_limit.c
+ * @brief Per-signal token bucket rate limiter.
+ *
+ * Tokens are kept in milli-tokens so fractional refill rates (adaptive
+ * scaling below 1 Hz) accumulate without floating point.
+ */
+
+#include <string.h>
+#include <linux/can.h>
+#include "can_rate_limit.h"
+
+/** @brief Number of standard (11-bit) CAN IDs */
+#define RL_IDS  (CAN_SFF_MASK + 1u)
+/** @brief Longest refill interval considered (10 s) */
+#define RL_MAX_DT_NS  10000000000ull
+
+/** @brief Token bucket per ID */
+typedef struct {
+    uint64_t last_ns;      /**< Last refill time, 0 = never used */
+    uint32_t milli_tokens; /**< Available tokens * 1000 */
+} rl_bucket_t;
+
+static rl_bucket_t rl_buckets[RL_IDS];
+static uint32_t rl_rate_hz = 10u;
+static uint32_t rl_burst = 2u;
+
+/**
+ * @brief Reset all buckets.
+ * @param rate_hz Refill rate in frames/s per ID (0 keeps 10 Hz).
+ * @param burst Bucket depth in frames (0 keeps 2).
+ */
+void can_rate_limit_init(uint32_t rate_hz, uint32_t burst)
+{
+    memset(rl_buckets, 0, sizeof(rl_buckets));
+    rl_rate_hz = (rate_hz != 0u) ? rate_hz : 10u;
+    rl_burst = (burst != 0u) ? burst : 2u;
+}
+
+/**
+ * @brief Try to take a token.
+ * @param can_id Standard CAN ID.
+ * @param now_ns Monotonic time in ns.
+ * @param scale_permille Refill rate scale, 1000 = configured rate.
+ * @return True if the frame may be sent now.
+ */
+bool can_rate_limit_take(uint32_t can_id, uint64_t now_ns, uint32_t scale_permille)
+{
+    rl_bucket_t *b = &rl_buckets[can_id & CAN_SFF_MASK];
+    uint64_t cap = (uint64_t)rl_burst * 1000u;
+
+    if (b->last_ns == 0u) {
+        b->milli_tokens = (uint32_t)cap;
+        b->last_ns = now_ns;
+    } else if (now_ns > b->last_ns) {
+        /* milli-tokens gained = dt[s] * rate * scale[permille]; dt capped so the product cannot overflow */
+        uint64_t dt = now_ns - b->last_ns;
+        if (dt > RL_MAX_DT_NS) {
+            dt = RL_MAX_DT_NS;
+        }
+        uint64_t gained = (dt * rl_rate_hz * scale_permille) / 1000000000ull;
+        /* keep last_ns until at least one milli-token accrued so frequent calls do not lose time */
+        if (gained > 0u) {
+            uint64_t tokens = b->milli_tokens + gained;
+            b->milli_tokens = (uint32_t)((tokens > cap) ? cap : tokens);
+            b->last_ns = now_ns;
+        }
+    } else {
+        /* clock did not advance */
+    }
+
+    if (b->milli_tokens >= 1000u) {
+        b->milli_tokens -= 1000u;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,13 @@
+#ifndef CAN_RATE_LIMIT_H
+#define CAN_RATE_LIMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-ID token buckets for throttled signals; not thread-safe, callers serialize
+void can_rate_limit_init(uint32_t rate_hz, uint32_t burst);
+
+// Take one token for can_id; refill rate is scaled by scale_permille (1000 = configured rate)
+bool can_rate_limit_take(uint32_t can_id, uint64_t now_ns, uint32_t scale_permille);
+
+#endif // CAN_RATE_LIMIT_H
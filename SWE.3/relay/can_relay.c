@@ -2,13 +2,17 @@
  * @file can_relay.c
  * @brief Generic CAN-controlled relay interface implementation.
  *
- * This module provides a SocketCAN backend for MCP2515 (can0) on Raspberry Pi.
+ * This module drives an MCP2515 (can0) on Raspberry Pi through a pluggable
+ * CAN backend (SocketCAN by default, see can_backend.h).
  * It implements CAN-based relay control with the following features:
- * - can_hw_send() using PF_CAN (SocketCAN)
+ * - can_hw_send() through the selected backend, in priority order (can_tx_queue.h)
+ * - Bus load estimation and adaptive throttling of low-priority signals
  * - Weak functions for relay hardware initialization and control
  * - Helper functions to open/close CAN socket
  * - Support for up to 8 relays with CAN command/status interface
  * - Additional signal sending functions for battery, velocity, charging status
+ * - Optional warm restart of relay and signal state (relay_state_store.h)
+ * - Multi-frame blobs over the kernel ISO-TP socket (can_isotp.h)
  *
  * @author [Your Name]
  * @date 2025
@@ -19,13 +23,16 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
-#include <unistd.h>
-#include <errno.h>
-#include <sys/socket.h>
-#include <sys/ioctl.h>
-#include <net/if.h>
+#include <time.h>
+#include <pthread.h>
 #include <linux/can.h>
-#include <linux/can/raw.h>
+#include "can_relay.h"
+#include "can_backend.h"
+#include "can_tx_queue.h"
+#include "relay_state_store.h"
+#include "can_bus_load.h"
+#include "can_rate_limit.h"
+#include "can_isotp.h"
 
 /** @brief Maximum number of relays supported */
 #define MAX_RELAYS         8u
@@ -34,14 +41,18 @@
 /** @brief CAN ID for relay status replies */
 #define CAN_STATUS_ID      0x401u
 
-/** @brief CAN ID for battery level signal */
-#define CAN_BATTERY_ID     0x100u
-/** @brief CAN ID for velocity signal */
-#define CAN_VELOCITY_ID    0x101u
-/** @brief CAN ID for charging active signal */
-#define CAN_CHARGING_ACTIVE_ID 0x102u
-/** @brief CAN ID for charge request signal */
-#define CAN_CHARGE_REQUEST_ID  0x103u
+/** @brief Frames read from the backend per poll */
+#define CAN_RX_BATCH       32u
+/** @brief Frames handed to the backend per send_batch() */
+#define CAN_TX_BATCH       16u
+/** @brief Default CAN bitrate in bit/s */
+#define CAN_DEFAULT_BITRATE     500000u
+/** @brief Default bus load ceiling in percent above which low-priority signals are throttled */
+#define CAN_DEFAULT_LOAD_CEILING 60u
+/** @brief Default per-signal rate while throttled, in frames/s */
+#define CAN_DEFAULT_THROTTLE_HZ  10u
+/** @brief Token bucket depth while throttled, in frames */
+#define CAN_THROTTLE_BURST       2u
 
 /** @brief Opcode for setting relay state */
 #define OPCODE_SET         0x01u
@@ -60,6 +71,11 @@
 /** @brief Relay state bitmask (up to 16 relays supported) */
 static uint16_t relay_state_mask = 0u;
 
+/** @brief Most verbose level that is printed; define as LOG_INFO for benchmark builds */
+#ifndef CAN_RELAY_LOG_LEVEL
+#define CAN_RELAY_LOG_LEVEL LOG_DEBUG
+#endif
+
 /** @brief Logging levels */
 typedef enum {
     LOG_ERROR,  /**< Error level */
@@ -84,75 +100,76 @@ typedef enum {
 static void log_message(log_level_t level, const char *msg)
 {
     const char *level_str[] = {"ERROR", "INFO", "DEBUG"};
+    if (level > CAN_RELAY_LOG_LEVEL) {
+        return;
+    }
     fprintf(stderr, "[%s] %s\n", level_str[level], msg);
 }
 
-/* ---------- Platform CAN backend (SocketCAN) ---------- */
+/* ---------- Platform CAN backend ---------- */
+
+/** @brief Selected CAN backend (SocketCAN unless overridden before init) */
+static can_backend_t *can_backend = NULL;
+/** @brief Backend has been opened */
+static bool can_open = false;
+/** @brief Serializes TX queue access, backend writes, signal persistence, bus load and metrics */
+static pthread_mutex_t can_tx_lock = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Bus load ceiling in permille (0 = throttling disabled) */
+static uint32_t can_load_ceiling = CAN_DEFAULT_LOAD_CEILING * 10u;
+/** @brief Throttled frames held back during a flush, requeued at its end */
+static struct can_frame can_tx_deferred[CAN_SFF_MASK + 1u];
+/** @brief Runtime counters */
+static can_relay_metrics_t can_metrics;
+/** @brief ISO-TP channel opened */
+static bool isotp_open = false;
 
-/** @brief Default CAN interface name */
-static char can_ifname[IF_NAMESIZE] = "can0";
-/** @brief CAN socket file descriptor */
-static int can_sock = -1;
+/**
+ * @brief Select the CAN backend used by the relay.
+ * @param backend Backend instance; NULL restores SocketCAN.
+ * @return CAN_RELAY_SUCCESS on success, CAN_RELAY_ERROR_CAN_NOT_OPEN if a backend is already open.
+ */
+int can_relay_set_backend(can_backend_t *backend)
+{
+    if (can_open) {
+        log_message(LOG_ERROR, "Cannot change CAN backend while open");
+        return CAN_RELAY_ERROR_CAN_NOT_OPEN;
+    }
+    can_backend = (backend != NULL) ? backend : can_backend_socketcan();
+    return CAN_RELAY_SUCCESS;
+}
 
 /**
- * @brief Open CAN socket on the given interface name.
- * @param ifname The CAN interface name (e.g., "can0"). If NULL or empty, uses default.
+ * @brief Open the CAN backend on the given interface name.
+ * @param ifname The CAN interface name (e.g., "can0"). If NULL or empty, uses backend default.
  * @return CAN_RELAY_SUCCESS on success, error code on failure.
  */
 can_relay_error_t can_platform_open(const char *ifname)
 {
-    if (ifname != NULL && ifname[0] != '\0') {
-        strncpy(can_ifname, ifname, IF_NAMESIZE - 1u);
-        can_ifname[IF_NAMESIZE - 1u] = '\0';
+    if (can_backend == NULL) {
+        can_backend = can_backend_socketcan();
     }
-
-    if (can_sock >= 0) {
-        log_message(LOG_DEBUG, "CAN socket already open");
+    if (can_open) {
+        log_message(LOG_DEBUG, "CAN backend already open");
         return CAN_RELAY_SUCCESS;
     }
-
-    struct ifreq ifr;
-    struct sockaddr_can addr;
-
-    can_sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if (can_sock < 0) {
-        log_message(LOG_ERROR, "Failed to create CAN socket");
-        return CAN_RELAY_ERROR_CAN_NOT_OPEN;
-    }
-
-    memset(&ifr, 0, sizeof(ifr));
-    strncpy(ifr.ifr_name, can_ifname, IF_NAMESIZE - 1u);
-    if (ioctl(can_sock, SIOCGIFINDEX, &ifr) < 0) {
-        log_message(LOG_ERROR, "Failed to get CAN interface index");
-        close(can_sock);
-        can_sock = -1;
-        return CAN_RELAY_ERROR_CAN_NOT_OPEN;
-    }
-
-    memset(&addr, 0, sizeof(addr));
-    addr.can_family = AF_CAN;
-    addr.can_ifindex = ifr.ifr_ifindex;
-
-    if (bind(can_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        log_message(LOG_ERROR, "Failed to bind CAN socket");
-        close(can_sock);
-        can_sock = -1;
+    if (can_backend->open(can_backend, ifname) != 0) {
+        log_message(LOG_ERROR, "Failed to open CAN backend");
         return CAN_RELAY_ERROR_CAN_NOT_OPEN;
     }
-
-    log_message(LOG_INFO, "CAN socket opened successfully");
+    can_open = true;
+    log_message(LOG_INFO, "CAN backend opened successfully");
     return CAN_RELAY_SUCCESS;
 }
 
 /**
- * @brief Close the CAN socket.
+ * @brief Close the CAN backend.
  */
 void can_platform_close(void)
 {
-    if (can_sock >= 0) {
-        close(can_sock);
-        can_sock = -1;
-        log_message(LOG_INFO, "CAN socket closed");
+    if (can_open) {
+        can_backend->close(can_backend);
+        can_open = false;
+        log_message(LOG_INFO, "CAN backend closed");
     }
 }
 
@@ -182,16 +199,95 @@ __attribute__((weak)) void relay_hw_set(uint8_t idx, bool on)
 }
 
 /**
- * @brief Send a CAN frame.
+ * @brief Current monotonic time in ns.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Decide whether a frame may go to the bus now.
+ * @note Safety and control classes are never throttled. Other frames need a
+ *       token while load exceeds the ceiling; refill slows as load rises.
+ */
+static bool can_tx_admit(const struct can_frame *frame, uint32_t load, uint64_t now)
+{
+    if (can_load_ceiling == 0u || load <= can_load_ceiling ||
+        can_tx_queue_class(frame->can_id) <= CAN_TX_CLASS_CONTROL) {
+        return true;
+    }
+    return can_rate_limit_take(frame->can_id, now, (can_load_ceiling * 1000u) / load);
+}
+
+/**
+ * @brief Hand pending frames to the backend, highest priority first.
+ * @note Caller must hold can_tx_lock. Stops at the first frame the backend
+ *       refuses (controller queue full); the rest stay queued for the next flush.
+ *       Throttled frames are requeued, so newer payloads replace them.
+ * @return CAN_RELAY_SUCCESS if the queue was drained or backend is busy with
+ *         some progress, CAN_RELAY_ERROR_CAN_SEND_FAILED if nothing could be sent.
+ */
+static can_relay_error_t can_tx_flush_locked(void)
+{
+    struct can_frame frames[CAN_TX_BATCH];
+    struct can_frame batch[CAN_TX_BATCH];
+    can_relay_error_t ret = CAN_RELAY_SUCCESS;
+    size_t deferred = 0u;
+    size_t n;
+    uint64_t now = now_ns();
+    uint32_t load = can_bus_load_permille(now);
+
+    while ((n = can_tx_queue_pop(frames, CAN_TX_BATCH)) > 0u) {
+        size_t count = 0u;
+        for (size_t i = 0u; i < n; ++i) {
+            if (can_tx_admit(&frames[i], load, now)) {
+                batch[count++] = frames[i];
+            } else {
+                can_tx_deferred[deferred++] = frames[i];
+                can_metrics.throttle_deferrals++;
+            }
+        }
+        if (count == 0u) {
+            continue;
+        }
+
+        int sent = can_backend->send_batch(can_backend, batch, count);
+        size_t done = (sent > 0) ? (size_t)sent : 0u;
+        for (size_t i = 0u; i < done; ++i) {
+            can_bus_load_add(batch[i].can_dlc, now);
+        }
+        can_metrics.tx_frames += done;
+        load = can_bus_load_permille(now);
+
+        if (done < count) {
+            can_tx_queue_requeue(&batch[done], count - done);
+            ret = (done > 0u) ? CAN_RELAY_SUCCESS : CAN_RELAY_ERROR_CAN_SEND_FAILED;
+            break;
+        }
+    }
+
+    can_tx_queue_requeue(can_tx_deferred, deferred);
+    return ret;
+}
+
+/**
+ * @brief Queue a CAN frame and flush, optionally persisting it as the last signal value.
  * @param id CAN identifier.
  * @param data Pointer to data payload (can be NULL if len is 0).
  * @param len Length of data (0-8).
- * @return CAN_RELAY_SUCCESS on success, error code on failure.
+ * @param persist True to save the payload to the state store in the same
+ *        critical section as the queue push, so the saved value always
+ *        matches the order frames reach the bus. Dropped frames are not saved.
+ * @return CAN_RELAY_SUCCESS if the frame was sent or queued, CAN_RELAY_ERROR_CAN_SEND_FAILED
+ *         if the backend is not open or a safety-class frame was dropped on a full FIFO.
  */
-can_relay_error_t can_hw_send(uint32_t id, const uint8_t *data, uint8_t len)
+static can_relay_error_t can_tx_send(uint32_t id, const uint8_t *data, uint8_t len, bool persist)
 {
-    if (can_sock < 0) {
-        log_message(LOG_ERROR, "CAN socket not open");
+    if (!can_open) {
+        log_message(LOG_ERROR, "CAN backend not open");
         return CAN_RELAY_ERROR_CAN_SEND_FAILED;
     }
     struct can_frame frame;
@@ -207,15 +303,110 @@ can_relay_error_t can_hw_send(uint32_t id, const uint8_t *data, uint8_t len)
         memcpy(frame.data, data, len);
     }
 
-    ssize_t n = write(can_sock, &frame, sizeof(frame));
-    if (n != (ssize_t)sizeof(frame)) {
-        log_message(LOG_ERROR, "Failed to write CAN frame");
+    pthread_mutex_lock(&can_tx_lock);
+    can_tx_push_result_t pushed = can_tx_queue_push(&frame);
+    if (persist && pushed != CAN_TX_PUSH_DROPPED) {
+        relay_state_save_signal(frame.can_id, frame.data, frame.can_dlc);
+    }
+    can_relay_error_t ret = can_tx_flush_locked();
+    pthread_mutex_unlock(&can_tx_lock);
+
+    if (pushed == CAN_TX_PUSH_DROPPED) {
+        log_message(LOG_ERROR, "Safety frame dropped, TX FIFO full");
         return CAN_RELAY_ERROR_CAN_SEND_FAILED;
     }
-    log_message(LOG_DEBUG, "CAN frame sent");
+    if (ret != CAN_RELAY_SUCCESS) {
+        log_message(LOG_DEBUG, "CAN controller busy, frame deferred");
+    } else {
+        log_message(LOG_DEBUG, "CAN frame sent");
+    }
     return CAN_RELAY_SUCCESS;
 }
 
+/**
+ * @brief Send a CAN frame.
+ * @param id CAN identifier.
+ * @param data Pointer to data payload (can be NULL if len is 0).
+ * @param len Length of data (0-8).
+ * @return CAN_RELAY_SUCCESS if the frame was sent or queued, error code if the backend is
+ *         not open or a safety-class frame was dropped because its FIFO is full.
+ * @note The frame is queued by priority and replaces any pending frame with
+ *       the same ID (safety-class IDs queue every frame). If the controller
+ *       is busy it stays queued and is retried on the next flush.
+ */
+can_relay_error_t can_hw_send(uint32_t id, const uint8_t *data, uint8_t len)
+{
+    return can_tx_send(id, data, len, false);
+}
+
+/**
+ * @brief Set TX priority class for a CAN ID.
+ * @param can_id Standard CAN ID.
+ * @param prio_class CAN_TX_CLASS_* (0 = highest).
+ * @return True on success, false if ID or class out of range.
+ * @note Call after init; init restores the default classes.
+ */
+bool can_relay_set_tx_class(uint32_t can_id, uint8_t prio_class)
+{
+    pthread_mutex_lock(&can_tx_lock);
+    bool ok = can_tx_queue_set_class(can_id, prio_class);
+    pthread_mutex_unlock(&can_tx_lock);
+    return ok;
+}
+
+/**
+ * @brief Configure bus load estimation and throttling.
+ * @param bitrate CAN bitrate in bit/s (0 keeps default).
+ * @param ceiling_pct Load in percent above which low-priority signals are throttled (0 disables).
+ * @param throttle_hz Per-signal rate while throttled at the ceiling (0 keeps default).
+ * @note Call after init; init restores the defaults.
+ */
+void can_relay_set_bus_limits(uint32_t bitrate, uint8_t ceiling_pct, uint32_t throttle_hz)
+{
+    pthread_mutex_lock(&can_tx_lock);
+    can_bus_load_init((bitrate != 0u) ? bitrate : CAN_DEFAULT_BITRATE);
+    can_rate_limit_init((throttle_hz != 0u) ? throttle_hz : CAN_DEFAULT_THROTTLE_HZ, CAN_THROTTLE_BURST);
+    can_load_ceiling = (uint32_t)ceiling_pct * 10u;
+    pthread_mutex_unlock(&can_tx_lock);
+}
+
+/**
+ * @brief Read runtime counters and current bus load.
+ * @param out Metrics to fill.
+ */
+void can_relay_get_metrics(can_relay_metrics_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&can_tx_lock);
+    *out = can_metrics;
+    out->bus_load_permille = can_bus_load_permille(now_ns());
+    out->tx_pending = (uint32_t)can_tx_queue_depth();
+    out->coalesced = can_tx_queue_coalesced();
+    out->safety_dropped = can_tx_queue_safety_dropped();
+    pthread_mutex_unlock(&can_tx_lock);
+}
+
+/**
+ * @brief Reset TX queue and apply default priority classes.
+ * @note Relay status and charge request outrank periodic signals even though
+ *       their IDs would lose arbitration.
+ */
+static void can_tx_init(void)
+{
+    pthread_mutex_lock(&can_tx_lock);
+    can_tx_queue_init();
+    can_bus_load_init(CAN_DEFAULT_BITRATE);
+    can_rate_limit_init(CAN_DEFAULT_THROTTLE_HZ, CAN_THROTTLE_BURST);
+    can_load_ceiling = CAN_DEFAULT_LOAD_CEILING * 10u;
+    memset(&can_metrics, 0, sizeof(can_metrics));
+    (void)can_tx_queue_set_class(CAN_STATUS_ID, CAN_TX_CLASS_SAFETY);
+    (void)can_tx_queue_set_class(CAN_CHARGE_REQUEST_ID, CAN_TX_CLASS_SAFETY);
+    (void)can_tx_queue_set_class(CAN_CHARGING_ACTIVE_ID, CAN_TX_CLASS_CONTROL);
+    pthread_mutex_unlock(&can_tx_lock);
+}
+
 /* ---------- Helpers ---------- */
 
 /**
@@ -249,6 +440,7 @@ int can_relay_init_ex(const char *can_iface)
 {
     relay_state_mask = 0u;
     relay_hw_init();
+    can_tx_init();
     /* try to open CAN interface; if it fails, still return -1 so caller can handle */
     if (can_platform_open(can_iface) != CAN_RELAY_SUCCESS) {
         log_message(LOG_ERROR, "Failed to initialize CAN relay");
@@ -266,6 +458,7 @@ void can_relay_init(void)
 {
     relay_state_mask = 0u;
     relay_hw_init();
+    can_tx_init();
     /* best-effort open; ignore return for legacy callers */
     (void)can_platform_open(NULL);
     log_message(LOG_INFO, "CAN relay initialized (legacy)");
@@ -277,6 +470,79 @@ void can_relay_init(void)
 void can_relay_close(void)
 {
     can_platform_close();
+    relay_state_close();
+    if (isotp_open) {
+        can_isotp_close();
+        isotp_open = false;
+    }
+}
+
+/**
+ * @brief Open the ISO-TP channel used by send_blob().
+ * @param ifname CAN interface name (SocketCAN only; the ring backend has no ISO-TP).
+ * @param tx_id CAN ID of outgoing ISO-TP frames.
+ * @param rx_id CAN ID of flow control frames from the peer.
+ * @param block_size Block size advertised in our flow control, 0 = no limit.
+ * @param stmin Separation time advertised in our flow control (ISO-TP encoding).
+ * @param tx_stmin_us Forced gap between our consecutive frames, 0 = use peer FC.
+ * @note block_size and stmin only affect FC frames we send while receiving;
+ *       send_blob() is paced by the peer's FC or tx_stmin_us.
+ * @return 0 on success, -1 on failure.
+ */
+int can_relay_isotp_open(const char *ifname, uint32_t tx_id, uint32_t rx_id,
+                         uint8_t block_size, uint8_t stmin, uint32_t tx_stmin_us)
+{
+    const can_isotp_config_t cfg = {
+        .tx_id = tx_id,
+        .rx_id = rx_id,
+        .block_size = block_size,
+        .stmin = stmin,
+        .tx_stmin_us = tx_stmin_us,
+    };
+    if (can_isotp_open(ifname, &cfg) != 0) {
+        log_message(LOG_ERROR, "Failed to open ISO-TP socket");
+        return -1;
+    }
+    isotp_open = true;
+    log_message(LOG_INFO, "ISO-TP channel opened");
+    return 0;
+}
+
+/**
+ * @brief Enable persistent state and restore the last saved state.
+ * @param path State file path (created if missing).
+ * @param reemit True to resend the last known signal values onto the bus.
+ * @return 0 on success (including an empty/new file), -1 if the file cannot be mapped.
+ * @note Call after init; relays are re-applied through relay_hw_set().
+ */
+int can_relay_restore_state(const char *path, bool reemit)
+{
+    struct timespec t0, t1;
+    relay_state_snapshot_t snap;
+    char msg[96];
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (relay_state_open(path) != 0) {
+        log_message(LOG_ERROR, "Failed to open relay state file");
+        return -1;
+    }
+    if (!relay_state_load(&snap)) {
+        log_message(LOG_INFO, "No saved relay state");
+        return 0;
+    }
+    (void)can_relay_set_mask(snap.relay_mask);
+    if (reemit) {
+        for (uint8_t i = 0u; i < snap.signal_count; ++i) {
+            (void)can_hw_send(snap.signals[i].can_id, snap.signals[i].data, snap.signals[i].len);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    long us = (long)(t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_nsec - t0.tv_nsec) / 1000L;
+    snprintf(msg, sizeof(msg), "Relay state restored (mask 0x%02X, %u signals%s) in %ld us",
+             (unsigned)snap.relay_mask, (unsigned)snap.signal_count, reemit ? " re-emitted" : "", us);
+    log_message(LOG_INFO, msg);
+    return 0;
 }
 
 /**
@@ -296,6 +562,7 @@ bool can_relay_set(uint8_t idx, bool on)
     } else {
         relay_state_mask &= ~(1u << idx);
     }
+    relay_state_save_relays(relay_state_mask);
     hw_apply(idx, on);
     log_message(LOG_DEBUG, "Relay set");
     return true;
@@ -430,6 +697,42 @@ bool can_relay_handle_can_msg(uint32_t can_id, const uint8_t *data, uint8_t len)
     return true;
 }
 
+/**
+ * @brief Read pending frames from the backend and dispatch them.
+ * @return Number of frames read, or -1 if the backend is not open or failed.
+ * @note Every received frame counts in bus load and rx_frames. On SocketCAN
+ *       that includes loopback copies of frames sent by other local sockets,
+ *       e.g. the ISO-TP data frames of send_blob() and the peer's FC frames;
+ *       only the relay's own raw-socket frames are counted at send time.
+ */
+int can_relay_poll(void)
+{
+    struct can_frame frames[CAN_RX_BATCH];
+
+    if (!can_open) {
+        return -1;
+    }
+    int n = can_backend->recv_batch(can_backend, frames, CAN_RX_BATCH);
+
+    /* received frames share the bus; then retry frames left queued by a busy controller or throttling */
+    pthread_mutex_lock(&can_tx_lock);
+    uint64_t now = now_ns();
+    for (int i = 0; i < n; ++i) {
+        can_bus_load_add(frames[i].can_dlc, now);
+    }
+    can_metrics.rx_frames += (n > 0) ? (uint64_t)n : 0u;
+    (void)can_tx_flush_locked();
+    pthread_mutex_unlock(&can_tx_lock);
+
+    for (int i = 0; i < n; ++i) {
+        if ((frames[i].can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0u) {
+            continue;
+        }
+        (void)can_relay_handle_can_msg(frames[i].can_id & CAN_SFF_MASK, frames[i].data, frames[i].can_dlc);
+    }
+    return n;
+}
+
 /**
  * @brief Set all relays by bitmask.
  * @param mask Bitmask for relay states.
@@ -442,6 +745,7 @@ bool can_relay_set_mask(uint16_t mask)
         hw_apply(i, on);
     }
     relay_state_mask = mask & ((1u << MAX_RELAYS) - 1u);
+    relay_state_save_relays(relay_state_mask);
     log_message(LOG_DEBUG, "Relay mask set");
     return true;
 }
@@ -456,7 +760,7 @@ bool can_relay_set_mask(uint16_t mask)
 can_relay_error_t send_battery_level(uint8_t level)
 {
     uint8_t data[1u] = {level};
-    can_relay_error_t ret = can_hw_send(CAN_BATTERY_ID, data, 1u);
+    can_relay_error_t ret = can_tx_send(CAN_BATTERY_ID, data, 1u, true);
     if (ret == CAN_RELAY_SUCCESS) {
         log_message(LOG_DEBUG, "Battery level sent");
     }
@@ -472,7 +776,7 @@ int send_velocity(float velocity)
 {
     uint8_t data[4u];
     memcpy(data, &velocity, sizeof(float));
-    int ret = can_hw_send(CAN_VELOCITY_ID, data, 4u);
+    int ret = can_tx_send(CAN_VELOCITY_ID, data, 4u, true);
     if (ret == 0) {
         log_message(LOG_DEBUG, "Velocity sent");
     }
@@ -487,7 +791,7 @@ int send_velocity(float velocity)
 int send_charging_active(bool active)
 {
     uint8_t data[1u] = {active ? 1u : 0u};
-    int ret = can_hw_send(CAN_CHARGING_ACTIVE_ID, data, 1u);
+    int ret = can_tx_send(CAN_CHARGING_ACTIVE_ID, data, 1u, true);
     if (ret == 0) {
         log_message(LOG_DEBUG, "Charging active sent");
     }
@@ -502,9 +806,41 @@ int send_charging_active(bool active)
 int send_charge_request(bool request)
 {
     uint8_t data[1u] = {request ? 1u : 0u};
-    int ret = can_hw_send(CAN_CHARGE_REQUEST_ID, data, 1u);
+    int ret = can_tx_send(CAN_CHARGE_REQUEST_ID, data, 1u, true);
     if (ret == 0) {
         log_message(LOG_DEBUG, "Charge request sent");
     }
     return ret;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Send a multi-frame blob over ISO-TP.
+ * @param data Payload.
+ * @param len Payload length (1..CAN_ISOTP_MAX_LEN).
+ * @return 0 on success, -1 on failure.
+ * @note Bypasses the TX queue: the kernel paces the PDU by flow control.
+ *       Its data and FC frames reach bus load through can_relay_poll(), as
+ *       loopback copies on the raw socket, while they are on the wire.
+ */
+int send_blob(const uint8_t *data, uint16_t len)
+{
+    uint64_t usec = 0u;
+
+    if (!isotp_open) {
+        log_message(LOG_ERROR, "ISO-TP channel not open");
+        return -1;
+    }
+    if (can_isotp_send(data, len, &usec) != 0) {
+        log_message(LOG_ERROR, "Failed to send blob");
+        return -1;
+    }
+
+    pthread_mutex_lock(&can_tx_lock);
+    can_metrics.blobs++;
+    can_metrics.blob_bytes += len;
+    can_metrics.blob_usec += usec;
+    pthread_mutex_unlock(&can_tx_lock);
+
+    log_message(LOG_DEBUG, "Blob sent");
+    return 0;
+}
@@ -4,17 +4,38 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+typedef struct can_backend can_backend_t;
+
+// Runtime metrics
+typedef struct {
+    uint32_t bus_load_permille;  // estimated utilization over the last 100 ms
+    uint32_t tx_pending;         // frames waiting in the TX queue
+    uint64_t tx_frames;          // frames handed to the backend
+    uint64_t rx_frames;          // frames received from the backend (incl. ISO-TP loopback)
+    uint64_t throttle_deferrals; // times a flush held a pending frame back for lack of a token
+                                 // (one frame counts once per flush until it is sent or replaced)
+    uint64_t coalesced;          // pending frames replaced by a newer payload
+    uint64_t safety_dropped;     // safety-class frames refused because their FIFO was full
+    uint64_t blobs;              // ISO-TP PDUs sent
+    uint64_t blob_bytes;         // ISO-TP payload bytes sent
+    uint64_t blob_usec;          // time spent in ISO-TP writes
+} can_relay_metrics_t;
+
 // CAN IDs for signals
 #define CAN_BATTERY_ID     0x100u
 #define CAN_VELOCITY_ID    0x101u
 #define CAN_CHARGING_ACTIVE_ID 0x102u
 #define CAN_CHARGE_REQUEST_ID  0x103u
 
-// Initialization
+// Initialization (select backend before init, NULL = SocketCAN)
+int can_relay_set_backend(can_backend_t *backend);
 int can_relay_init_ex(const char *can_iface);
 void can_relay_init(void);
 void can_relay_close(void);
 
+// Warm restart: persist state in mmap'd file and restore it (call after init)
+int can_relay_restore_state(const char *path, bool reemit);
+
 // Relay control (existing)
 bool can_relay_set(uint8_t idx, bool on);
 bool can_relay_toggle(uint8_t idx);
@@ -23,11 +44,24 @@ bool can_relay_set_mask(uint16_t mask);
 
 // CAN message handling
 bool can_relay_handle_can_msg(uint32_t can_id, const uint8_t *data, uint8_t len);
+int can_relay_poll(void);
+
+// TX priority (0 = highest, see can_tx_queue.h), call after init
+bool can_relay_set_tx_class(uint32_t can_id, uint8_t prio_class);
+
+// ISO-TP channel for send_blob() (SocketCAN backends only)
+int can_relay_isotp_open(const char *ifname, uint32_t tx_id, uint32_t rx_id,
+                         uint8_t block_size, uint8_t stmin, uint32_t tx_stmin_us);
+
+// Bus load ceiling / throttling (call after init) and metrics
+void can_relay_set_bus_limits(uint32_t bitrate, uint8_t ceiling_pct, uint32_t throttle_hz);
+void can_relay_get_metrics(can_relay_metrics_t *out);
 
 // Signal sending
 int send_battery_level(uint8_t level);
 int send_velocity(float velocity);
 int send_charging_active(bool active);
 int send_charge_request(bool request);
+int send_blob(const uint8_t *data, uint16_t len);
 
 #endif // CAN_RELAY_H
\ No newline at end of file
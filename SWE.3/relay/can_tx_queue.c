@@ -0,0 +1,319 @@
+/*
+ * @file can_tx_queue.c
+ * @brief Priority TX queue mirroring CAN bus arbitration.
+ *
+ * Pending frames are held in a bucket queue keyed by (class, 11-bit ID).
+ * A two-level bitmap indexes the occupied keys, so push and pop-min are
+ * a few bit operations regardless of depth. Each ID has a single slot:
+ * a newer payload replaces the pending one, so a burst of updates to one
+ * signal can never delay a higher-priority frame by more than one slot.
+ *
+ * Safety-class IDs are not coalesced: one ID can carry different
+ * messages (e.g. status replies for different relays), so they get a
+ * short FIFO from a small pool instead and every frame is sent in order.
+ * A frame that finds its FIFO full is refused, never merged.
+ */
+
+#include <string.h>
+#include "can_tx_queue.h"
+
+/** @brief Number of standard (11-bit) CAN IDs */
+#define TXQ_IDS          (CAN_SFF_MASK + 1u)
+/** @brief Number of (class, ID) keys */
+#define TXQ_KEYS         (CAN_TX_CLASS_COUNT * TXQ_IDS)
+/** @brief Leaf bitmap words */
+#define TXQ_LEAF_WORDS   (TXQ_KEYS / 64u)
+/** @brief Summary bitmap words (one bit per leaf word) */
+#define TXQ_TOP_WORDS    ((TXQ_LEAF_WORDS + 63u) / 64u)
+/** @brief IDs that can hold a FIFO at the same time */
+#define TXQ_FIFO_IDS     32u
+/** @brief Frames per FIFO (power of two) */
+#define TXQ_FIFO_DEPTH   8u
+/** @brief Index mask for TXQ_FIFO_DEPTH */
+#define TXQ_FIFO_MASK    (TXQ_FIFO_DEPTH - 1u)
+
+/** @brief Pending frames of a non-coalescing ID */
+typedef struct {
+    struct can_frame frame[TXQ_FIFO_DEPTH];  /**< Ring of frames */
+    uint8_t head;                            /**< Oldest frame */
+    uint8_t count;                           /**< Frames pending */
+    bool used;                               /**< Assigned to an ID */
+} tx_fifo_t;
+
+/** @brief Queue state */
+typedef struct {
+    uint64_t top[TXQ_TOP_WORDS];        /**< Non-empty leaf words */
+    uint64_t leaf[TXQ_LEAF_WORDS];      /**< Occupied keys */
+    struct can_frame frame[TXQ_IDS];    /**< Pending frame per ID */
+    uint8_t prio_class[TXQ_IDS];        /**< Class per ID */
+    uint8_t fifo_of[TXQ_IDS];           /**< FIFO index + 1 per ID, 0 = coalescing */
+    tx_fifo_t fifo[TXQ_FIFO_IDS];       /**< FIFO pool for safety-class IDs */
+    size_t depth;                       /**< Pending frames */
+    uint64_t coalesced;                 /**< Frames replaced before sending */
+    uint64_t safety_dropped;            /**< Safety-class frames refused on a full FIFO */
+} tx_queue_t;
+
+static tx_queue_t txq;
+
+/**
+ * @brief Compute bitmap key for an ID.
+ */
+static inline uint32_t txq_key(uint32_t id)
+{
+    return ((uint32_t)txq.prio_class[id] * TXQ_IDS) + id;
+}
+
+/**
+ * @brief Test whether key is set.
+ */
+static inline bool txq_test(uint32_t key)
+{
+    return (txq.leaf[key / 64u] >> (key % 64u)) & 1u;
+}
+
+/**
+ * @brief Set key in both bitmap levels.
+ */
+static inline void txq_set(uint32_t key)
+{
+    uint32_t w = key / 64u;
+    txq.leaf[w] |= (uint64_t)1u << (key % 64u);
+    txq.top[w / 64u] |= (uint64_t)1u << (w % 64u);
+}
+
+/**
+ * @brief Clear key, and its summary bit if the leaf word became empty.
+ */
+static inline void txq_clear(uint32_t key)
+{
+    uint32_t w = key / 64u;
+    txq.leaf[w] &= ~((uint64_t)1u << (key % 64u));
+    if (txq.leaf[w] == 0u) {
+        txq.top[w / 64u] &= ~((uint64_t)1u << (w % 64u));
+    }
+}
+
+/**
+ * @brief FIFO of an ID, NULL if the ID coalesces.
+ */
+static inline tx_fifo_t *txq_fifo(uint32_t id)
+{
+    return (txq.fifo_of[id] != 0u) ? &txq.fifo[txq.fifo_of[id] - 1u] : NULL;
+}
+
+/**
+ * @brief Give an ID a FIFO, moving its pending frame into it.
+ * @return False if the pool is exhausted.
+ */
+static bool txq_fifo_attach(uint32_t id, bool pending)
+{
+    for (uint8_t i = 0u; i < TXQ_FIFO_IDS; ++i) {
+        tx_fifo_t *fifo = &txq.fifo[i];
+        if (!fifo->used) {
+            fifo->used = true;
+            fifo->head = 0u;
+            fifo->count = pending ? 1u : 0u;
+            fifo->frame[0] = txq.frame[id];
+            txq.fifo_of[id] = (uint8_t)(i + 1u);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Return an ID's FIFO to the pool, keeping only the newest pending frame.
+ */
+static void txq_fifo_detach(uint32_t id)
+{
+    tx_fifo_t *fifo = txq_fifo(id);
+    if (fifo->count > 0u) {
+        txq.frame[id] = fifo->frame[(fifo->head + fifo->count - 1u) & TXQ_FIFO_MASK];
+        txq.coalesced += fifo->count - 1u;
+        txq.depth -= fifo->count - 1u;
+    }
+    fifo->used = false;
+    txq.fifo_of[id] = 0u;
+}
+
+/**
+ * @brief Reset queue and set every ID to CAN_TX_CLASS_NORMAL.
+ */
+void can_tx_queue_init(void)
+{
+    memset(&txq, 0, sizeof(txq));
+    memset(txq.prio_class, CAN_TX_CLASS_NORMAL, sizeof(txq.prio_class));
+}
+
+/**
+ * @brief Assign a priority class to an ID; pending frames move with it.
+ * @param can_id Standard CAN ID.
+ * @param prio_class Class (CAN_TX_CLASS_*).
+ * @return True on success, false if ID or class out of range, or if
+ *         TXQ_FIFO_IDS IDs are already in the safety class.
+ * @note Leaving the safety class keeps only the newest pending frame.
+ */
+bool can_tx_queue_set_class(uint32_t can_id, uint8_t prio_class)
+{
+    if (can_id > CAN_SFF_MASK || prio_class >= CAN_TX_CLASS_COUNT) {
+        return false;
+    }
+    uint32_t old_key = txq_key(can_id);
+    bool pending = txq_test(old_key);
+    bool fifo = (prio_class == CAN_TX_CLASS_SAFETY);
+    if (fifo && txq.fifo_of[can_id] == 0u) {
+        if (!txq_fifo_attach(can_id, pending)) {
+            return false;
+        }
+    } else if (!fifo && txq.fifo_of[can_id] != 0u) {
+        txq_fifo_detach(can_id);
+    }
+    txq.prio_class[can_id] = prio_class;
+    if (pending) {
+        txq_clear(old_key);
+        txq_set(txq_key(can_id));
+    }
+    return true;
+}
+
+/**
+ * @brief Get priority class of an ID.
+ * @param can_id CAN ID (masked to 11 bits).
+ * @return Class (CAN_TX_CLASS_*).
+ */
+uint8_t can_tx_queue_class(uint32_t can_id)
+{
+    return txq.prio_class[can_id & CAN_SFF_MASK];
+}
+
+/**
+ * @brief Queue a frame, replacing any pending frame with the same ID.
+ * @param frame Frame to queue (standard ID).
+ * @return CAN_TX_PUSH_QUEUED, CAN_TX_PUSH_REPLACED if it replaced a pending
+ *         frame, or CAN_TX_PUSH_DROPPED if a safety-class FIFO is full.
+ * @note Safety-class IDs append to their FIFO instead and are never replaced.
+ */
+can_tx_push_result_t can_tx_queue_push(const struct can_frame *frame)
+{
+    uint32_t id = frame->can_id & CAN_SFF_MASK;
+    uint32_t key = txq_key(id);
+    tx_fifo_t *fifo = txq_fifo(id);
+    can_tx_push_result_t result = CAN_TX_PUSH_QUEUED;
+
+    if (fifo != NULL) {
+        if (fifo->count == TXQ_FIFO_DEPTH) {
+            txq.safety_dropped++;
+            return CAN_TX_PUSH_DROPPED;
+        }
+        fifo->count++;
+        fifo->frame[(fifo->head + fifo->count - 1u) & TXQ_FIFO_MASK] = *frame;
+        if (fifo->count == 1u) {
+            txq_set(key);
+        }
+    } else {
+        if (txq_test(key)) {
+            result = CAN_TX_PUSH_REPLACED;
+        } else {
+            txq_set(key);
+        }
+        txq.frame[id] = *frame;
+    }
+    if (result == CAN_TX_PUSH_QUEUED) {
+        txq.depth++;
+    } else {
+        txq.coalesced++;
+    }
+    return result;
+}
+
+/**
+ * @brief Remove up to max frames, highest priority first.
+ * @param frames Output array.
+ * @param max Capacity of frames.
+ * @return Number of frames removed.
+ */
+size_t can_tx_queue_pop(struct can_frame *frames, size_t max)
+{
+    size_t n = 0u;
+    uint32_t t = 0u;
+
+    while (n < max && t < TXQ_TOP_WORDS) {
+        if (txq.top[t] == 0u) {
+            t++;
+            continue;
+        }
+        uint32_t w = (t * 64u) + (uint32_t)__builtin_ctzll(txq.top[t]);
+        uint32_t key = (w * 64u) + (uint32_t)__builtin_ctzll(txq.leaf[w]);
+        uint32_t id = key % TXQ_IDS;
+        tx_fifo_t *fifo = txq_fifo(id);
+        if (fifo != NULL) {
+            frames[n++] = fifo->frame[fifo->head];
+            fifo->head = (uint8_t)((fifo->head + 1u) & TXQ_FIFO_MASK);
+            fifo->count--;
+            if (fifo->count == 0u) {
+                txq_clear(key);
+            }
+        } else {
+            frames[n++] = txq.frame[id];
+            txq_clear(key);
+        }
+        txq.depth--;
+    }
+    return n;
+}
+
+/**
+ * @brief Put popped frames back at the front of the queue.
+ * @param frames Frames in the order they were popped.
+ * @param count Number of frames.
+ * @note Safety-class frames go back ahead of frames queued since, so a
+ *       FIFO keeps its order. Frames were popped under the same lock, so a
+ *       FIFO cannot be full here; if it is, the frame counts as dropped.
+ */
+void can_tx_queue_requeue(const struct can_frame *frames, size_t count)
+{
+    for (size_t i = count; i > 0u; --i) {
+        const struct can_frame *frame = &frames[i - 1u];
+        uint32_t id = frame->can_id & CAN_SFF_MASK;
+        tx_fifo_t *fifo = txq_fifo(id);
+        if (fifo == NULL) {
+            (void)can_tx_queue_push(frame);
+            continue;
+        }
+        if (fifo->count == TXQ_FIFO_DEPTH) {
+            txq.safety_dropped++;
+            continue;
+        }
+        fifo->head = (uint8_t)((fifo->head - 1u) & TXQ_FIFO_MASK);
+        fifo->frame[fifo->head] = *frame;
+        fifo->count++;
+        txq.depth++;
+        if (fifo->count == 1u) {
+            txq_set(txq_key(id));
+        }
+    }
+}
+
+/**
+ * @brief Number of pending frames.
+ */
+size_t can_tx_queue_depth(void)
+{
+    return txq.depth;
+}
+
+/**
+ * @brief Number of frames replaced by a newer payload before being sent.
+ */
+uint64_t can_tx_queue_coalesced(void)
+{
+    return txq.coalesced;
+}
+
+/**
+ * @brief Number of safety-class frames refused because their FIFO was full.
+ */
+uint64_t can_tx_queue_safety_dropped(void)
+{
+    return txq.safety_dropped;
+}
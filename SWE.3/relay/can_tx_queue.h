@@ -0,0 +1,48 @@
+#ifndef CAN_TX_QUEUE_H
+#define CAN_TX_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <linux/can.h>
+
+// Priority classes, lower value is sent first; within a class lower CAN ID wins (bus arbitration)
+#define CAN_TX_CLASS_SAFETY  0u
+#define CAN_TX_CLASS_CONTROL 1u
+#define CAN_TX_CLASS_NORMAL  2u
+#define CAN_TX_CLASS_BULK    3u
+#define CAN_TX_CLASS_COUNT   4u
+
+// Pending-frame queue, one slot per 11-bit ID (a short FIFO for safety-class IDs);
+// not thread-safe, callers serialize
+void can_tx_queue_init(void);
+
+// Assign a priority class to an ID (default CAN_TX_CLASS_NORMAL); false if out of range
+// or the safety-class FIFO pool is exhausted
+bool can_tx_queue_set_class(uint32_t can_id, uint8_t prio_class);
+
+// Priority class of an ID
+uint8_t can_tx_queue_class(uint32_t can_id);
+
+// Outcome of can_tx_queue_push()
+typedef enum {
+    CAN_TX_PUSH_QUEUED,    // newly queued
+    CAN_TX_PUSH_REPLACED,  // replaced a pending frame with the same ID
+    CAN_TX_PUSH_DROPPED    // safety-class FIFO full, frame not queued
+} can_tx_push_result_t;
+
+// Queue frame
+can_tx_push_result_t can_tx_queue_push(const struct can_frame *frame);
+
+// Remove up to max frames in priority order
+size_t can_tx_queue_pop(struct can_frame *frames, size_t max);
+
+// Put popped frames back ahead of newer ones (frames in pop order)
+void can_tx_queue_requeue(const struct can_frame *frames, size_t count);
+
+// Number of pending frames / frames dropped by same-ID coalescing / safety frames dropped on a full FIFO
+size_t can_tx_queue_depth(void);
+uint64_t can_tx_queue_coalesced(void);
+uint64_t can_tx_queue_safety_dropped(void);
+
+#endif // CAN_TX_QUEUE_H
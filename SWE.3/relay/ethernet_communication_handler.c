@@ -7,13 +7,21 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <stdint.h>
 #include "can_relay.h"
+#include "ethernet_communication_handler.h"
+#include "can_isotp.h"
 
-#define PORT 5000U
-#define BUFFER_SIZE 1024U
+/* Large enough for a hex-encoded blob of CAN_ISOTP_MAX_LEN bytes */
+#define BUFFER_SIZE ((2U * CAN_ISOTP_MAX_LEN) + 128U)
 #define SIGNAL_NAME_MAX_LEN 50U
-#define BACKLOG 5
+/* Binary blob message: "BLOB" + 16-bit big-endian length + payload */
+#define BLOB_MAGIC "BLOB"
+#define BLOB_HEADER_LEN 6U
+/* Whole message must arrive within this time, so a stalled client cannot block the worker */
+#define CLIENT_TIMEOUT_MS 1000
 
 static bool extract_signal(const char * const json, char * const signal)
 {
@@ -21,7 +29,8 @@ static bool extract_signal(const char * const json, char * const signal)
     const char *signal_start = strstr(json, "\"signal\"");
     if (signal_start != NULL)
     {
-        signal_start = strstr(signal_start, "\"");
+        /* Skip the key itself, then find the opening quote of the value */
+        signal_start = strstr(signal_start + sizeof("\"signal\"") - 1U, "\"");
         if (signal_start != NULL)
         {
             signal_start++;
@@ -89,6 +98,69 @@ static bool extract_value(const char * const json, const char * const signal, vo
     return success;
 }
 
+static int hex_nibble(char c)
+{
+    int v = -1;
+    if ((c >= '0') && (c <= '9'))
+    {
+        v = c - '0';
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+        v = (c - 'a') + 10;
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+        v = (c - 'A') + 10;
+    }
+    else
+    {
+        /* Not a hex digit */
+    }
+    return v;
+}
+
+/* Hex payload of {"signal": "blob", "data": "0a1b..."} */
+static bool extract_blob(const char * const json, uint8_t * const data, uint16_t * const len)
+{
+    bool success = false;
+    const char *p = strstr(json, "\"data\"");
+    if (p != NULL)
+    {
+        p = strchr(p + sizeof("\"data\"") - 1U, '"');
+    }
+    if (p != NULL)
+    {
+        size_t n = 0U;
+        p++;
+        success = true;
+        while ((*p != '"') && success)
+        {
+            int hi = hex_nibble(p[0]);
+            int lo = (hi >= 0) ? hex_nibble(p[1]) : -1;
+            if ((lo < 0) || (n >= CAN_ISOTP_MAX_LEN))
+            {
+                success = false;
+            }
+            else
+            {
+                data[n] = (uint8_t)((hi << 4) | lo);
+                n++;
+                p += 2;
+            }
+        }
+        if (success && (n > 0U))
+        {
+            *len = (uint16_t)n;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+    return success;
+}
+
 /* Simple JSON parser for {"signal": "name", "value": value} */
 static int parse_json(const char * const json, char * const signal, void * const value, int * const type)
 {
@@ -114,92 +186,238 @@ static int parse_json(const char * const json, char * const signal, void * const
     return result;
 }
 
+int ethernet_process_message(const char * const json)
+{
+    int result = -1;
+    char signal[SIGNAL_NAME_MAX_LEN];
+    union
+    {
+        int i;
+        float f;
+        bool b;
+    } val;
+    int type;
+    if ((json != NULL) && extract_signal(json, signal) && (strcmp(signal, "blob") == 0))
+    {
+        uint8_t blob[CAN_ISOTP_MAX_LEN];
+        uint16_t blob_len = 0U;
+        if (extract_blob(json, blob, &blob_len))
+        {
+            result = send_blob(blob, blob_len);
+        }
+    }
+    else if (parse_json(json, signal, &val, &type) == 0)
+    {
+        if ((strcmp(signal, "battery_level") == 0) && (type == 0))
+        {
+            result = send_battery_level((uint8_t)val.i);
+        }
+        else if ((strcmp(signal, "velocity") == 0) && (type == 1))
+        {
+            result = send_velocity(val.f);
+        }
+        else if ((strcmp(signal, "charging_active") == 0) && (type == 2))
+        {
+            result = send_charging_active(val.b);
+        }
+        else if ((strcmp(signal, "charge_request") == 0) && (type == 2))
+        {
+            result = send_charge_request(val.b);
+        }
+        else
+        {
+            /* Invalid signal or type */
+        }
+    }
+    return result;
+}
+
+/* Bytes needed for a complete message, 0 while unknown */
+static size_t binary_blob_size(const char * const buffer, size_t len)
+{
+    size_t needed = 0U;
+    if ((len >= BLOB_HEADER_LEN) && (memcmp(buffer, BLOB_MAGIC, 4U) == 0))
+    {
+        needed = BLOB_HEADER_LEN + (((size_t)(uint8_t)buffer[4] << 8) | (uint8_t)buffer[5]);
+    }
+    return needed;
+}
+
+/* Header announces an empty blob or one larger than ISO-TP can carry */
+static bool blob_header_invalid(const char * const buffer, size_t len)
+{
+    size_t needed = binary_blob_size(buffer, len);
+    return (needed != 0U) && ((needed == BLOB_HEADER_LEN) || ((needed - BLOB_HEADER_LEN) > CAN_ISOTP_MAX_LEN));
+}
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((int64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static bool message_complete(const char * const buffer, size_t len)
+{
+    bool complete = false;
+    if ((len >= 4U) && (memcmp(buffer, BLOB_MAGIC, 4U) == 0))
+    {
+        size_t needed = binary_blob_size(buffer, len);
+        complete = (needed != 0U) && (len >= needed);
+    }
+    else
+    {
+        /* JSON message ends with its closing brace */
+        complete = (memchr(buffer, '}', len) != NULL);
+    }
+    return complete;
+}
+
 static void handle_client(int client_sock)
 {
     char buffer[BUFFER_SIZE];
-    ssize_t bytes_read = read(client_sock, buffer, BUFFER_SIZE - 1U);
-    if (bytes_read > 0)
-    {
-        buffer[bytes_read] = '\0';
+    size_t total = 0U;
+    bool done = false;
+    bool rejected = false;
+    const int64_t deadline = monotonic_ms() + CLIENT_TIMEOUT_MS;
 
-        char signal[SIGNAL_NAME_MAX_LEN];
-        union
-        {
-            int i;
-            float f;
-            bool b;
-        } val;
-        int type;
-        if (parse_json(buffer, signal, &val, &type) == 0)
+    /* Blobs span several reads; stop at a complete message, EOF, full buffer or deadline */
+    while (!done && (total < (BUFFER_SIZE - 1U)))
+    {
+        struct pollfd pfd = { .fd = client_sock, .events = POLLIN, .revents = 0 };
+        int64_t remaining = deadline - monotonic_ms();
+        if ((remaining > 0) && (poll(&pfd, 1U, (int)remaining) > 0))
         {
-            if ((strcmp(signal, "battery_level") == 0) && (type == 0))
-            {
-                (void)send_battery_level((uint8_t)val.i);
-            }
-            else if ((strcmp(signal, "velocity") == 0) && (type == 1))
+            ssize_t bytes_read = read(client_sock, &buffer[total], (BUFFER_SIZE - 1U) - total);
+            if (bytes_read > 0)
             {
-                (void)send_velocity(val.f);
+                total += (size_t)bytes_read;
+                /* Reject a bad blob length as soon as the header is in, not after reading the payload */
+                rejected = blob_header_invalid(buffer, total);
+                done = rejected || message_complete(buffer, total);
             }
-            else if ((strcmp(signal, "charging_active") == 0) && (type == 2))
-            {
-                (void)send_charging_active(val.b);
-            }
-            else if ((strcmp(signal, "charge_request") == 0) && (type == 2))
+            else
             {
-                (void)send_charge_request(val.b);
+                done = true;
             }
-            else
+        }
+        else
+        {
+            /* Timed out or poll failed: drop the partial message */
+            rejected = true;
+            done = true;
+        }
+    }
+
+    if (rejected)
+    {
+        fprintf(stderr, "Client message rejected (timeout or invalid blob length)\n");
+    }
+    else if (total > 0U)
+    {
+        size_t blob_size = binary_blob_size(buffer, total);
+        buffer[total] = '\0';
+        if (blob_size != 0U)
+        {
+            if ((blob_size <= total) && (blob_size > BLOB_HEADER_LEN))
             {
-                /* Invalid signal or type */
+                (void)send_blob((const uint8_t *)&buffer[BLOB_HEADER_LEN], (uint16_t)(blob_size - BLOB_HEADER_LEN));
             }
         }
+        else
+        {
+            (void)ethernet_process_message(buffer);
+        }
     }
     (void)close(client_sock);
 }
 
-int ethernet_init(void)
+static bool fill_bind_addr(const ethernet_config_t * const config, struct sockaddr_in * const addr)
+{
+    bool success = true;
+
+    (void)memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(config->port);
+    if ((config->bind_addr == NULL) || (config->bind_addr[0] == '\0'))
+    {
+        addr->sin_addr.s_addr = INADDR_ANY;
+    }
+    else if (inet_pton(AF_INET, config->bind_addr, &addr->sin_addr) != 1)
+    {
+        fprintf(stderr, "Invalid bind address %s\n", config->bind_addr);
+        success = false;
+    }
+    else
+    {
+        /* Address parsed */
+    }
+    return success;
+}
+
+int ethernet_init_ex(const ethernet_config_t * const config)
 {
     int server_sock = -1;
     bool initialization_success = false;
+    struct sockaddr_in server_addr;
 
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock >= 0)
+    if ((config != NULL) && fill_bind_addr(config, &server_addr))
     {
-        struct sockaddr_in server_addr;
-        (void)memset(&server_addr, 0, sizeof(server_addr));
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_addr.s_addr = INADDR_ANY;
-        server_addr.sin_port = htons(PORT);
-
-        if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) >= 0)
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock >= 0)
         {
-            if (listen(sock, BACKLOG) >= 0)
+            int one = 1;
+            bool options_success = (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) >= 0);
+            if (options_success && config->reuse_port)
             {
-                /* Set non-blocking */
-                if (fcntl(sock, F_SETFL, O_NONBLOCK) >= 0)
+                /* Kernel load-balances accepts across all listeners bound to the same port */
+                options_success = (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) >= 0);
+            }
+
+            if (options_success && (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) >= 0))
+            {
+                if (listen(sock, config->backlog) >= 0)
                 {
-                    server_sock = sock;
-                    initialization_success = true;
+                    /* Set non-blocking */
+                    if (fcntl(sock, F_SETFL, O_NONBLOCK) >= 0)
+                    {
+                        server_sock = sock;
+                        initialization_success = true;
+                    }
                 }
             }
-        }
 
-        if (!initialization_success)
-        {
-            (void)close(sock);
+            if (!initialization_success)
+            {
+                (void)close(sock);
+            }
         }
     }
 
     return server_sock;
 }
 
+int ethernet_init(void)
+{
+    const ethernet_config_t config = {
+        .bind_addr = NULL,
+        .port = ETHERNET_DEFAULT_PORT,
+        .backlog = ETHERNET_DEFAULT_BACKLOG,
+        .reuse_port = false,
+    };
+    return ethernet_init_ex(&config);
+}
+
 void ethernet_handle(int server_sock)
 {
     struct sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
     int client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_len);
-    if (client_sock >= 0)
+    /* Drain everything queued since the last tick so bursts are not refused */
+    while (client_sock >= 0)
     {
         handle_client(client_sock);
+        client_len = sizeof(client_addr);
+        client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_len);
     }
 }
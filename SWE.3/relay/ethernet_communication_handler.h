@@ -1,10 +1,32 @@
 #ifndef ETHERNET_COMMUNICATION_HANDLER_H
 #define ETHERNET_COMMUNICATION_HANDLER_H
 
-// Initialize ethernet server, returns server socket fd
+#include <stdint.h>
+#include <stdbool.h>
+
+// Defaults used by ethernet_init()
+#define ETHERNET_DEFAULT_PORT    5000U
+#define ETHERNET_DEFAULT_BACKLOG 128
+
+// Listener socket options
+typedef struct
+{
+    const char *bind_addr;  // IPv4 address, NULL or "" binds INADDR_ANY
+    uint16_t port;
+    int backlog;
+    bool reuse_port;        // SO_REUSEPORT, one listener per worker
+} ethernet_config_t;
+
+// Initialize ethernet server with defaults, returns server socket fd
 int ethernet_init();
 
-// Handle incoming connections and messages (non-blocking)
+// Initialize ethernet server with given options, returns server socket fd
+int ethernet_init_ex(const ethernet_config_t * const config);
+
+// Parse one JSON message and forward it to CAN, returns 0 on success
+int ethernet_process_message(const char * const json);
+
+// Handle incoming connections and messages (non-blocking, drains accept queue)
 void ethernet_handle(int server_sock);
 
-#endif // ETHERNET_COMMUNICATION_HANDLER_H
\ No newline at end of file
+#endif // ETHERNET_COMMUNICATION_HANDLER_H
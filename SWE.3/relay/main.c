@@ -1,38 +1,178 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <time.h>
 #include "can_relay.h"
 #include "ethernet_communication_handler.h"
+#include "relay_config.h"
+#include "can_backend.h"
 
-volatile bool running = true;
+// Written by the signal handler, read by the main thread and every worker
+static atomic_bool running = true;
+
+typedef struct {
+    pthread_t thread;
+    int server_sock;
+    uint32_t cpu;
+} worker_t;
 
 void signal_handler(int sig) {
     (void)sig;
-    running = false;
+    atomic_store(&running, false);
+}
+
+// Pin worker to one core so its listener's accept queue stays cache-local
+static void pin_to_cpu(uint32_t cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % (uint32_t)cpus, &set);
+    (void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
 }
 
-int main() {
+static void print_metrics(void) {
+    can_relay_metrics_t m;
+    can_relay_get_metrics(&m);
+    printf("bus_load=%u.%u%% tx=%llu rx=%llu pending=%u throttle_deferrals=%llu coalesced=%llu safety_dropped=%llu\n",
+           m.bus_load_permille / 10u, m.bus_load_permille % 10u,
+           (unsigned long long)m.tx_frames, (unsigned long long)m.rx_frames, m.tx_pending,
+           (unsigned long long)m.throttle_deferrals, (unsigned long long)m.coalesced,
+           (unsigned long long)m.safety_dropped);
+    if (m.blobs != 0u && m.blob_usec != 0u) {
+        printf("isotp blobs=%llu bytes=%llu rate=%.1f KiB/s\n",
+               (unsigned long long)m.blobs, (unsigned long long)m.blob_bytes,
+               ((double)m.blob_bytes / 1024.0) / ((double)m.blob_usec / 1e6));
+    }
+    fflush(stdout);
+}
+
+// Ring backend in the daemon is a null bus: discard what the relay sent so the ring never fills
+static void drain_ring(void) {
+    struct can_frame frames[256];
+    while (can_backend_ring_drain(frames, 256u) == 256u) {
+    }
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    struct pollfd pfd = { .fd = w->server_sock, .events = POLLIN };
+
+    pin_to_cpu(w->cpu);
+    while (atomic_load(&running)) {
+        // 10ms timeout keeps shutdown latency the same as the old polling loop
+        if (poll(&pfd, 1, 10) > 0) {
+            ethernet_handle(w->server_sock);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    relay_config_t config;
+    relay_config_defaults(&config);
+    if (relay_config_parse_args(&config, argc, argv) != 0) {
+        relay_config_usage(argv[0]);
+        return 1;
+    }
+
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-  
-    // Initialize ethernet server
-    int server_sock = ethernet_init();
-    if (server_sock < 0) {
-        fprintf(stderr, "Failed to initialize ethernet server\n");
+    // Initialize CAN; only the first interface is driven by the relay module
+    (void)can_relay_set_backend(can_backend_find(config.can_backend));
+    if (can_relay_init_ex(config.can_ifaces[0]) != 0) {
+        fprintf(stderr, "Failed to initialize CAN interface %s\n", config.can_ifaces[0]);
+        return 1;
+    }
+    can_relay_set_bus_limits(config.can_bitrate, config.load_ceiling_pct, config.throttle_hz);
+    for (uint8_t i = 0u; i < config.tx_class_count; ++i) {
+        if (!can_relay_set_tx_class(config.tx_classes[i].can_id, config.tx_classes[i].prio_class)) {
+            fprintf(stderr, "TX class of 0x%03X not applied\n", (unsigned)config.tx_classes[i].can_id);
+        }
+    }
+    if (config.isotp_enabled &&
+        can_relay_isotp_open(config.can_ifaces[0], config.isotp_tx_id, config.isotp_rx_id,
+                             config.isotp_block_size, config.isotp_stmin, config.isotp_tx_stmin_us) != 0) {
+        fprintf(stderr, "Failed to open ISO-TP channel on %s\n", config.can_ifaces[0]);
+        can_relay_close();
+        return 1;
+    }
+    if (config.state_file[0] != '\0' && can_relay_restore_state(config.state_file, config.state_reemit) != 0) {
+        fprintf(stderr, "Failed to open state file %s\n", config.state_file);
+        can_relay_close();
         return 1;
     }
+    for (uint8_t i = 1u; i < config.can_iface_count; ++i) {
+        fprintf(stderr, "CAN interface %s ignored, only one interface supported\n", config.can_ifaces[i]);
+    }
+
+    // Initialize ethernet server, one SO_REUSEPORT listener per worker
+    const ethernet_config_t eth_config = {
+        .bind_addr = config.bind_addr,
+        .port = config.port,
+        .backlog = config.backlog,
+        .reuse_port = config.workers > 1u,
+    };
+    worker_t workers[RELAY_CONFIG_MAX_WORKERS];
+    uint32_t started = 0u;
+    bool init_ok = true;
+
+    for (uint32_t i = 0u; (i < config.workers) && init_ok; ++i) {
+        workers[i].cpu = i;
+        workers[i].server_sock = ethernet_init_ex(&eth_config);
+        if (workers[i].server_sock < 0) {
+            fprintf(stderr, "Failed to initialize ethernet server\n");
+            init_ok = false;
+        } else if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start worker %u\n", i);
+            close(workers[i].server_sock);
+            init_ok = false;
+        } else {
+            started++;
+        }
+    }
 
-    printf("Relay server started. Listening on port %d\n", 5000);
+    if (init_ok) {
+        printf("Relay server started. Listening on %s:%u (%u workers, backlog %d, CAN %s via %s)\n",
+               config.bind_addr, config.port, config.workers, config.backlog, config.can_ifaces[0],
+               config.can_backend);
+    } else {
+        atomic_store(&running, false);
+    }
+
+    // Main thread services inbound CAN (relay commands) while workers serve Ethernet
+    time_t next_metrics = time(NULL) + (time_t)config.metrics_interval;
+    const bool ring_backend = strcmp(config.can_backend, "ring") == 0;
+    while (atomic_load(&running)) {
+        if (ring_backend) {
+            drain_ring();
+        }
+        if (can_relay_poll() <= 0) {
+            usleep(10000);  // 10ms delay
+        }
+        if (config.metrics_interval != 0u && time(NULL) >= next_metrics) {
+            print_metrics();
+            next_metrics += (time_t)config.metrics_interval;
+        }
+    }
 
-    while (running) {
-        ethernet_handle(server_sock);
-        usleep(10000);  // 10ms delay
+    for (uint32_t i = 0u; i < started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+        close(workers[i].server_sock);
     }
 
-    close(server_sock);
+    can_relay_close();
     printf("Relay server stopped\n");
-    return 0;
+    return init_ok ? 0 : 1;
 }
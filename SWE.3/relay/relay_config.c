@@ -0,0 +1,480 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "relay_config.h"
+#include "ethernet_communication_handler.h"
+#include "can_backend.h"
+#include "can_tx_queue.h"
+
+#define CONFIG_LINE_MAX_LEN 256U
+#define DEFAULT_BIND_ADDR "0.0.0.0"
+#define DEFAULT_CAN_IFACE "can0"
+#define DEFAULT_VCAN_IFACE "vcan0"
+#define DEFAULT_CAN_BACKEND "socketcan"
+#define DEFAULT_CAN_BITRATE 500000U
+#define DEFAULT_LOAD_CEILING 60U
+#define DEFAULT_THROTTLE_HZ 10U
+#define DEFAULT_ISOTP_TX_ID 0x6F0U
+#define DEFAULT_ISOTP_RX_ID 0x6F8U
+
+static bool parse_ulong(const char * const text, unsigned long min, unsigned long max, unsigned long * const out)
+{
+    bool success = false;
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long v = strtoul(text, &end, 10);
+    if ((errno == 0) && (end != text) && (*end == '\0') && (v >= min) && (v <= max))
+    {
+        *out = v;
+        success = true;
+    }
+    return success;
+}
+
+/* Comma separated list, e.g. "can0,vcan0" */
+static bool parse_can_ifaces(relay_config_t * const config, const char * const text)
+{
+    bool success = true;
+    uint8_t count = 0U;
+    const char *p = text;
+
+    while ((*p != '\0') && success)
+    {
+        const char *comma = strchr(p, ',');
+        size_t len = (comma != NULL) ? (size_t)(comma - p) : strlen(p);
+
+        if ((len == 0U) || (len >= IF_NAMESIZE) || (count >= RELAY_CONFIG_MAX_CAN_IFACES))
+        {
+            success = false;
+        }
+        else
+        {
+            (void)memcpy(config->can_ifaces[count], p, len);
+            config->can_ifaces[count][len] = '\0';
+            count++;
+            p += len;
+            if (*p == ',')
+            {
+                p++;
+            }
+        }
+    }
+
+    if (success && (count > 0U))
+    {
+        config->can_iface_count = count;
+        config->can_iface_set = true;
+    }
+    else
+    {
+        success = false;
+    }
+    return success;
+}
+
+/* Comma separated id:class pairs, e.g. "0x101:3,0x100:3" */
+static bool parse_tx_classes(relay_config_t * const config, const char * const text)
+{
+    bool success = true;
+    uint8_t count = 0U;
+    const char *p = text;
+
+    while ((*p != '\0') && success)
+    {
+        char *end = NULL;
+        unsigned long id = strtoul(p, &end, 0);
+        if ((end == p) || (*end != ':') || (id > CAN_SFF_MASK) || (count >= RELAY_CONFIG_MAX_TX_CLASSES))
+        {
+            success = false;
+        }
+        else
+        {
+            p = end + 1;
+            unsigned long prio_class = strtoul(p, &end, 10);
+            if ((end == p) || ((*end != ',') && (*end != '\0')) || (prio_class >= CAN_TX_CLASS_COUNT))
+            {
+                success = false;
+            }
+            else
+            {
+                config->tx_classes[count].can_id = (uint32_t)id;
+                config->tx_classes[count].prio_class = (uint8_t)prio_class;
+                count++;
+                p = (*end == ',') ? (end + 1) : end;
+            }
+        }
+    }
+
+    if (success)
+    {
+        config->tx_class_count = count;
+    }
+    return success;
+}
+
+/* workers = 0 selects one worker per online CPU */
+static uint32_t resolve_workers(unsigned long requested)
+{
+    unsigned long workers = requested;
+    if (workers == 0UL)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (cpus > 0L) ? (unsigned long)cpus : 1UL;
+    }
+    if (workers > RELAY_CONFIG_MAX_WORKERS)
+    {
+        workers = RELAY_CONFIG_MAX_WORKERS;
+    }
+    return (uint32_t)workers;
+}
+
+static bool apply_option(relay_config_t * const config, const char * const key, const char * const value)
+{
+    bool success = false;
+    unsigned long v = 0UL;
+
+    if (strcmp(key, "bind") == 0)
+    {
+        if (strlen(value) < RELAY_CONFIG_ADDR_MAX_LEN)
+        {
+            (void)strcpy(config->bind_addr, value);
+            success = true;
+        }
+    }
+    else if (strcmp(key, "port") == 0)
+    {
+        if (parse_ulong(value, 1UL, 65535UL, &v))
+        {
+            config->port = (uint16_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "backlog") == 0)
+    {
+        if (parse_ulong(value, 1UL, 65535UL, &v))
+        {
+            config->backlog = (int)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "can") == 0)
+    {
+        success = parse_can_ifaces(config, value);
+    }
+    else if (strcmp(key, "backend") == 0)
+    {
+        if ((strlen(value) < RELAY_CONFIG_NAME_MAX_LEN) && (can_backend_find(value) != NULL))
+        {
+            (void)strcpy(config->can_backend, value);
+            success = true;
+        }
+    }
+    else if (strcmp(key, "tx_class") == 0)
+    {
+        success = parse_tx_classes(config, value);
+    }
+    else if (strcmp(key, "bitrate") == 0)
+    {
+        if (parse_ulong(value, 10000UL, 1000000UL, &v))
+        {
+            config->can_bitrate = (uint32_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "load_ceiling") == 0)
+    {
+        if (parse_ulong(value, 0UL, 100UL, &v))
+        {
+            config->load_ceiling_pct = (uint8_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "throttle_hz") == 0)
+    {
+        if (parse_ulong(value, 1UL, 10000UL, &v))
+        {
+            config->throttle_hz = (uint32_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "metrics_interval") == 0)
+    {
+        if (parse_ulong(value, 0UL, 86400UL, &v))
+        {
+            config->metrics_interval = (uint32_t)v;
+            success = true;
+        }
+    }
+    else if ((strcmp(key, "isotp_tx_id") == 0) || (strcmp(key, "isotp_rx_id") == 0))
+    {
+        char *end = NULL;
+        v = strtoul(value, &end, 0);
+        if ((end != value) && (*end == '\0') && (v <= CAN_SFF_MASK))
+        {
+            if (strcmp(key, "isotp_tx_id") == 0)
+            {
+                config->isotp_tx_id = (uint32_t)v;
+            }
+            else
+            {
+                config->isotp_rx_id = (uint32_t)v;
+            }
+            config->isotp_enabled = true;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "isotp_bs") == 0)
+    {
+        if (parse_ulong(value, 0UL, 255UL, &v))
+        {
+            config->isotp_block_size = (uint8_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "isotp_stmin") == 0)
+    {
+        /* ISO-TP encoding: 0-127 ms, 0xF1-0xF9 = 100-900 us */
+        char *end = NULL;
+        v = strtoul(value, &end, 0);
+        if ((end != value) && (*end == '\0') && ((v <= 0x7FUL) || ((v >= 0xF1UL) && (v <= 0xF9UL))))
+        {
+            config->isotp_stmin = (uint8_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "isotp_tx_stmin_us") == 0)
+    {
+        if (parse_ulong(value, 0UL, 127000UL, &v))
+        {
+            config->isotp_tx_stmin_us = (uint32_t)v;
+            success = true;
+        }
+    }
+    else if (strcmp(key, "state_file") == 0)
+    {
+        if (strlen(value) < RELAY_CONFIG_PATH_MAX_LEN)
+        {
+            (void)strcpy(config->state_file, value);
+            success = true;
+        }
+    }
+    else if (strcmp(key, "state_reemit") == 0)
+    {
+        if ((strcmp(value, "1") == 0) || (strcmp(value, "true") == 0))
+        {
+            config->state_reemit = true;
+            success = true;
+        }
+        else if ((strcmp(value, "0") == 0) || (strcmp(value, "false") == 0))
+        {
+            config->state_reemit = false;
+            success = true;
+        }
+        else
+        {
+            /* Invalid boolean */
+        }
+    }
+    else if (strcmp(key, "workers") == 0)
+    {
+        if (parse_ulong(value, 0UL, RELAY_CONFIG_MAX_WORKERS, &v))
+        {
+            config->workers = resolve_workers(v);
+            success = true;
+        }
+    }
+    else
+    {
+        /* Unknown key */
+    }
+
+    if (!success)
+    {
+        fprintf(stderr, "Invalid config option %s=%s\n", key, value);
+    }
+    return success;
+}
+
+static char *trim(char *text)
+{
+    while (isspace((unsigned char)*text) != 0)
+    {
+        text++;
+    }
+    char *end = text + strlen(text);
+    while ((end > text) && (isspace((unsigned char)end[-1]) != 0))
+    {
+        end--;
+    }
+    *end = '\0';
+    return text;
+}
+
+void relay_config_defaults(relay_config_t * const config)
+{
+    (void)memset(config, 0, sizeof(*config));
+    (void)strcpy(config->bind_addr, DEFAULT_BIND_ADDR);
+    config->port = ETHERNET_DEFAULT_PORT;
+    config->backlog = ETHERNET_DEFAULT_BACKLOG;
+    (void)strcpy(config->can_ifaces[0], DEFAULT_CAN_IFACE);
+    config->can_iface_count = 1U;
+    (void)strcpy(config->can_backend, DEFAULT_CAN_BACKEND);
+    config->can_bitrate = DEFAULT_CAN_BITRATE;
+    config->load_ceiling_pct = DEFAULT_LOAD_CEILING;
+    config->throttle_hz = DEFAULT_THROTTLE_HZ;
+    config->isotp_tx_id = DEFAULT_ISOTP_TX_ID;
+    config->isotp_rx_id = DEFAULT_ISOTP_RX_ID;
+    config->workers = 1U;
+}
+
+int relay_config_load_file(relay_config_t * const config, const char * const path)
+{
+    int result = 0;
+    char line[CONFIG_LINE_MAX_LEN];
+    unsigned int line_no = 0U;
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Cannot open config file %s\n", path);
+        result = -1;
+    }
+    else
+    {
+        while (fgets(line, (int)sizeof(line), f) != NULL)
+        {
+            line_no++;
+            char *hash = strchr(line, '#');
+            if (hash != NULL)
+            {
+                *hash = '\0';
+            }
+            char *entry = trim(line);
+            if (*entry == '\0')
+            {
+                continue;
+            }
+            char *eq = strchr(entry, '=');
+            if (eq == NULL)
+            {
+                fprintf(stderr, "%s:%u: expected key = value\n", path, line_no);
+                result = -1;
+                continue;
+            }
+            *eq = '\0';
+            if (!apply_option(config, trim(entry), trim(eq + 1)))
+            {
+                result = -1;
+            }
+        }
+        (void)fclose(f);
+    }
+    return result;
+}
+
+void relay_config_usage(const char * const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-c file] [-a addr] [-p port] [-b backlog] [-i can0[,can1]] [-B backend] [-P id:class,...]\n"
+            "          [-s state_file [-r]] [-w workers]\n"
+            "  -c file     load key = value config file (bind, port, backlog, can, backend, tx_class,\n"
+            "              bitrate, load_ceiling, throttle_hz, metrics_interval, isotp_tx_id, isotp_rx_id,\n"
+            "              isotp_bs, isotp_stmin, isotp_tx_stmin_us, state_file, state_reemit, workers)\n"
+            "  -a addr     bind address (default %s)\n"
+            "  -p port     TCP port (default %u)\n"
+            "  -b backlog  listen backlog per worker (default %d)\n"
+            "  -i ifaces   comma separated CAN interfaces (default %s, %s with -B vcan)\n"
+            "  -B backend  CAN backend: socketcan, vcan or ring (default %s)\n"
+            "  -P list     TX priority class per CAN ID, 0 = highest .. 3 = bulk\n"
+            "  -s file     persist relay/signal state in file and restore it at startup\n"
+            "  -r          re-emit restored signal values onto the bus\n"
+            "  -w workers  listener threads, 0 = one per CPU (default 1)\n",
+            prog, DEFAULT_BIND_ADDR, ETHERNET_DEFAULT_PORT, ETHERNET_DEFAULT_BACKLOG, DEFAULT_CAN_IFACE,
+            DEFAULT_VCAN_IFACE,
+            DEFAULT_CAN_BACKEND);
+}
+
+int relay_config_parse_args(relay_config_t * const config, int argc, char * const argv[])
+{
+    static const char * const optstring = "c:a:p:b:i:B:P:s:rw:h";
+    int result = 0;
+    int opt;
+
+    /* First pass: config file, so command line options override it */
+    opterr = 0;
+    while ((opt = getopt(argc, argv, optstring)) != -1)
+    {
+        if (opt == 'c')
+        {
+            if (relay_config_load_file(config, optarg) != 0)
+            {
+                result = -1;
+            }
+        }
+    }
+
+    optind = 1;
+    opterr = 1;
+    while ((result == 0) && ((opt = getopt(argc, argv, optstring)) != -1))
+    {
+        bool ok = true;
+        switch (opt)
+        {
+        case 'c':
+            break;
+        case 'a':
+            ok = apply_option(config, "bind", optarg);
+            break;
+        case 'p':
+            ok = apply_option(config, "port", optarg);
+            break;
+        case 'b':
+            ok = apply_option(config, "backlog", optarg);
+            break;
+        case 'i':
+            ok = apply_option(config, "can", optarg);
+            break;
+        case 'B':
+            ok = apply_option(config, "backend", optarg);
+            break;
+        case 'P':
+            ok = apply_option(config, "tx_class", optarg);
+            break;
+        case 's':
+            ok = apply_option(config, "state_file", optarg);
+            break;
+        case 'r':
+            config->state_reemit = true;
+            break;
+        case 'w':
+            ok = apply_option(config, "workers", optarg);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+        {
+            result = -1;
+        }
+    }
+
+    if ((result == 0) && (optind < argc))
+    {
+        fprintf(stderr, "Unexpected argument %s\n", argv[optind]);
+        result = -1;
+    }
+
+    /* vcan backend defaults to vcan0 unless interfaces were given */
+    if ((result == 0) && !config->can_iface_set && (strcmp(config->can_backend, "vcan") == 0))
+    {
+        (void)strcpy(config->can_ifaces[0], DEFAULT_VCAN_IFACE);
+        config->can_iface_count = 1U;
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef RELAY_CONFIG_H
+#define RELAY_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <net/if.h>
+
+// Limits
+#define RELAY_CONFIG_ADDR_MAX_LEN   64U
+#define RELAY_CONFIG_MAX_CAN_IFACES 4U
+#define RELAY_CONFIG_MAX_WORKERS    64U
+#define RELAY_CONFIG_NAME_MAX_LEN   16U
+#define RELAY_CONFIG_MAX_TX_CLASSES 16U
+#define RELAY_CONFIG_PATH_MAX_LEN   256U
+
+// TX priority class override for one CAN ID
+typedef struct
+{
+    uint32_t can_id;
+    uint8_t prio_class;
+} relay_config_tx_class_t;
+
+// Runtime configuration of the relay process
+typedef struct
+{
+    char bind_addr[RELAY_CONFIG_ADDR_MAX_LEN];
+    uint16_t port;
+    int backlog;
+    char can_ifaces[RELAY_CONFIG_MAX_CAN_IFACES][IF_NAMESIZE];
+    uint8_t can_iface_count;
+    bool can_iface_set;         // interfaces given explicitly, otherwise follow the backend default
+    char can_backend[RELAY_CONFIG_NAME_MAX_LEN];
+    relay_config_tx_class_t tx_classes[RELAY_CONFIG_MAX_TX_CLASSES];
+    uint8_t tx_class_count;
+    uint32_t can_bitrate;
+    uint8_t load_ceiling_pct;   // 0 = no throttling
+    uint32_t throttle_hz;
+    uint32_t metrics_interval;  // seconds, 0 = off
+    bool isotp_enabled;
+    uint32_t isotp_tx_id;
+    uint32_t isotp_rx_id;
+    uint8_t isotp_block_size;   // BS/STmin in FC frames we send; blob sends follow the peer's FC
+    uint8_t isotp_stmin;
+    uint32_t isotp_tx_stmin_us;
+    char state_file[RELAY_CONFIG_PATH_MAX_LEN];  // empty = no persistence
+    bool state_reemit;
+    uint32_t workers;
+} relay_config_t;
+
+// Fill config with built-in defaults
+void relay_config_defaults(relay_config_t * const config);
+
+// Load "key = value" lines from file, returns 0 on success
+int relay_config_load_file(relay_config_t * const config, const char * const path);
+
+// Apply command line options (config file first, then overrides), returns 0 on success
+int relay_config_parse_args(relay_config_t * const config, int argc, char * const argv[]);
+
+// Print command line usage
+void relay_config_usage(const char * const prog);
+
+#endif // RELAY_CONFIG_H
@@ -0,0 +1,241 @@
+/*
+ * @file relay_state_store.c
+ * @brief Persistent relay and signal state in a memory-mapped file.
+ *
+ * The file holds a versioned header and two checksummed records. Each
+ * update writes the record that is not current with the next generation
+ * number, so a crash mid-write leaves the previous record intact; load
+ * picks the valid record with the highest generation. Writes go to the
+ * shared mapping only (no msync/fsync), which survives process crashes
+ * and restarts; the kernel flushes to disk in the background.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "relay_state_store.h"
+#include "can_relay.h"
+
+/** @brief File magic ("RLST") */
+#define STATE_MAGIC    0x524C5354u
+/** @brief Layout version, bump on any record change */
+#define STATE_VERSION  1u
+
+/** @brief One state record */
+typedef struct {
+    uint64_t generation;                            /**< Update counter, 0 = never written */
+    uint16_t relay_mask;                            /**< Relay states */
+    uint8_t signal_valid;                           /**< Bit per tracked signal */
+    uint8_t reserved;
+    uint8_t signal_len[RELAY_STATE_MAX_SIGNALS];     /**< Payload lengths */
+    uint8_t signal_data[RELAY_STATE_MAX_SIGNALS][8]; /**< Last payloads */
+    uint32_t crc;                                   /**< CRC-32 of the fields above */
+} state_record_t;
+
+/** @brief File layout */
+typedef struct {
+    uint32_t magic;          /**< STATE_MAGIC */
+    uint16_t version;        /**< STATE_VERSION */
+    uint16_t record_size;    /**< sizeof(state_record_t) */
+    state_record_t rec[2];   /**< Alternating records */
+} state_file_t;
+
+/** @brief Tracked signal IDs, index matches record slots */
+static const uint32_t tracked_ids[RELAY_STATE_MAX_SIGNALS] = {
+    CAN_BATTERY_ID, CAN_VELOCITY_ID, CAN_CHARGING_ACTIVE_ID, CAN_CHARGE_REQUEST_ID
+};
+
+/** @brief Mapped file, NULL when closed */
+static state_file_t *state_map = NULL;
+/** @brief In-memory copy of the current record */
+static state_record_t state_current;
+/** @brief Serializes updates from Ethernet workers and CAN thread */
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief CRC-32 (IEEE, reflected), nibble table.
+ */
+static uint32_t crc32_calc(const void *buf, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+        0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0u; i < len; ++i) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Check record checksum.
+ */
+static bool record_valid(const state_record_t *rec)
+{
+    return rec->generation != 0u &&
+           rec->crc == crc32_calc(rec, offsetof(state_record_t, crc));
+}
+
+/**
+ * @brief Write state_current to the non-current slot.
+ * @note Caller must hold state_lock.
+ */
+static void record_commit(void)
+{
+    state_current.generation++;
+    state_current.crc = crc32_calc(&state_current, offsetof(state_record_t, crc));
+    state_map->rec[state_current.generation & 1u] = state_current;
+}
+
+/**
+ * @brief Map the state file, creating or resetting it if the layout does not match.
+ * @param path File path.
+ * @return 0 on success, -1 on failure.
+ */
+int relay_state_open(const char *path)
+{
+    if (path == NULL || path[0] == '\0') {
+        return -1;
+    }
+    if (state_map != NULL) {
+        return 0;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)sizeof(state_file_t)) < 0) {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, sizeof(state_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&state_lock);
+    state_map = (state_file_t *)map;
+    memset(&state_current, 0, sizeof(state_current));
+    if (state_map->magic != STATE_MAGIC || state_map->version != STATE_VERSION ||
+        state_map->record_size != sizeof(state_record_t)) {
+        memset(state_map, 0, sizeof(*state_map));
+        state_map->magic = STATE_MAGIC;
+        state_map->version = STATE_VERSION;
+        state_map->record_size = (uint16_t)sizeof(state_record_t);
+    } else {
+        for (uint8_t i = 0u; i < 2u; ++i) {
+            const state_record_t *rec = &state_map->rec[i];
+            if (record_valid(rec) && rec->generation > state_current.generation) {
+                state_current = *rec;
+            }
+        }
+    }
+    pthread_mutex_unlock(&state_lock);
+    return 0;
+}
+
+/**
+ * @brief Unmap the state file.
+ */
+void relay_state_close(void)
+{
+    pthread_mutex_lock(&state_lock);
+    if (state_map != NULL) {
+        munmap(state_map, sizeof(state_file_t));
+        state_map = NULL;
+    }
+    pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * @brief Get the last valid persisted state.
+ * @param out Snapshot to fill.
+ * @return True if a valid record exists, false otherwise.
+ */
+bool relay_state_load(relay_state_snapshot_t *out)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&state_lock);
+    if (state_map != NULL && state_current.generation != 0u) {
+        memset(out, 0, sizeof(*out));
+        out->relay_mask = state_current.relay_mask;
+        for (uint8_t i = 0u; i < RELAY_STATE_MAX_SIGNALS; ++i) {
+            if ((state_current.signal_valid >> i) & 1u) {
+                uint8_t n = out->signal_count++;
+                out->signals[n].can_id = tracked_ids[i];
+                out->signals[n].len = state_current.signal_len[i];
+                memcpy(out->signals[n].data, state_current.signal_data[i], 8u);
+            }
+        }
+        found = true;
+    }
+    pthread_mutex_unlock(&state_lock);
+    return found;
+}
+
+/**
+ * @brief Persist relay states.
+ * @param mask Relay bitmask.
+ */
+void relay_state_save_relays(uint16_t mask)
+{
+    pthread_mutex_lock(&state_lock);
+    if (state_map != NULL && (state_current.relay_mask != mask || state_current.generation == 0u)) {
+        state_current.relay_mask = mask;
+        record_commit();
+    }
+    pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * @brief Persist last value of a tracked signal.
+ * @param can_id Signal CAN ID; untracked IDs are ignored.
+ * @param data Payload.
+ * @param len Payload length (truncated to 8).
+ */
+void relay_state_save_signal(uint32_t can_id, const uint8_t *data, uint8_t len)
+{
+    uint8_t idx = 0u;
+    while (idx < RELAY_STATE_MAX_SIGNALS && tracked_ids[idx] != can_id) {
+        idx++;
+    }
+    if (idx == RELAY_STATE_MAX_SIGNALS || (data == NULL && len > 0u)) {
+        return;
+    }
+    if (len > 8u) {
+        len = 8u;
+    }
+
+    pthread_mutex_lock(&state_lock);
+    if (state_map != NULL) {
+        uint8_t payload[8] = {0u};
+        if (len > 0u) {
+            memcpy(payload, data, len);
+        }
+        bool same = ((state_current.signal_valid >> idx) & 1u) &&
+                    state_current.signal_len[idx] == len &&
+                    memcmp(state_current.signal_data[idx], payload, 8u) == 0;
+        if (!same) {
+            state_current.signal_valid |= (uint8_t)(1u << idx);
+            state_current.signal_len[idx] = len;
+            memcpy(state_current.signal_data[idx], payload, 8u);
+            record_commit();
+        }
+    }
+    pthread_mutex_unlock(&state_lock);
+}
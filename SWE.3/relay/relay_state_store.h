@@ -0,0 +1,34 @@
+#ifndef RELAY_STATE_STORE_H
+#define RELAY_STATE_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Signals tracked by the store (battery, velocity, charging_active, charge_request)
+#define RELAY_STATE_MAX_SIGNALS 4u
+
+// Last persisted state
+typedef struct
+{
+    uint16_t relay_mask;
+    uint8_t signal_count;
+    struct
+    {
+        uint32_t can_id;
+        uint8_t len;
+        uint8_t data[8];
+    } signals[RELAY_STATE_MAX_SIGNALS];
+} relay_state_snapshot_t;
+
+// Map state file (created if missing), returns 0 on success
+int relay_state_open(const char *path);
+void relay_state_close(void);
+
+// Read last valid record, false if none
+bool relay_state_load(relay_state_snapshot_t *out);
+
+// Update state; no-ops while the store is closed, untracked IDs are ignored
+void relay_state_save_relays(uint16_t mask);
+void relay_state_save_signal(uint32_t can_id, const uint8_t *data, uint8_t len);
+
+#endif // RELAY_STATE_STORE_H